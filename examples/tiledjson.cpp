@@ -1,11 +1,11 @@
-// Minimal loader for tiled's json file format in unencoded format (store as CSV)
+// Minimal loader for tiled's json file format with CSV or (uncompressed) base64 layers
 
 // Notice: This loader is NOT complete and files must be correctly saved
 //         but for quick and small projects this will work.
-//         In tiled make sure that the layer format is specified as CSV when
-//         viewing the Map->Map properties.. menu.
+//         In tiled make sure that the layer format is specified as CSV or Base64
+//         (uncompressed) when viewing the Map->Map properties.. menu.
 
-#include <fstream>
+#include <iostream>
 #include <rpoco/json.hpp>
 
 // Only handles square objects for the time being
@@ -29,10 +29,12 @@ struct tiled_layer {
 	int y;
 	int width;
 	int height;
-	std::vector<int> data; // valid for "tilelayer"'s saved as CSV
+	std::string encoding; // "csv" (the default) or "base64"
+	std::string compression; // "zlib", "gzip" or "zstd" for compressed base64 data, empty otherwise
+	std::vector<int> data; // valid for "tilelayer"'s, read from both CSV arrays and base64 strings
 	std::vector<tiled_object> objects; // valid for "objectgroup"'s
 
-	RPOCO(type,x,y,width,height,name,data,objects);
+	RPOCO(type,x,y,width,height,name,encoding,compression,_(data,rpoco::json::base64()),objects);
 };
 
 // Stores info about the images used for the tilemap
@@ -68,8 +70,15 @@ int main(int argc,char **argv) {
 		std::cout<<"no filename specified\n";
 		return -1;
 	}
-	std::ifstream is(argv[1]);
-	if (rpoco::parse_json(is,tfile)) {
+	// the file is memory mapped and parsed in place
+	if (rpoco::parse_json_file(argv[1],tfile)) {
+		// compressed data decodes as base64 but isn't tile ids
+		for (auto &layer:tfile.layers) {
+			if (!layer.compression.empty()) {
+				std::cout<<"the layer "<<layer.name<<" in "<<argv[1]<<" is "<<layer.compression<<" compressed, save it uncompressed\n";
+				return -1;
+			}
+		}
 		// insert code here to do something useful with the tiledata :)
 		std::cout<<"the file "<<argv[1]<<" was correctly parsed\n";
 		return 0;
@@ -13,69 +13,371 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <float.h>
+#include <locale.h>
+#include <limits>
 
 #include <unordered_set>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__) && !defined(__AVX2__)
+#include <tmmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if __cplusplus >= 201703L || _MSVC_LANG >= 201703L
+#include <string_view>
+#include <charconv>
+#endif
 
 
 namespace rpoco {
-	// Functions to parse the istream or string into the templatized target
+	// Functions to parse the istream, string or memory buffer into the templatized target
 	// these functions will return true if the parsing was successful.
+	// Strings and buffers are parsed in place without copying them into a stream.
 	// Optional support exists for the parser to skip over C/C++ style comments.
 	// By default UTF16 surrogate decoding is done so that the UTF8 strings
 	// has full codepoints instead of surrogate pairs.
 	template<typename X> bool parse_json(std::istream &in, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
-	template<typename X> bool parse_json(std::string &str, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	template<typename X> bool parse_json(const std::string &str, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	template<typename X> bool parse_json(const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	// Parses a file, regular files are memory mapped and parsed in place.
+	template<typename X> bool parse_json_file(const std::string &path, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	// Parses with json::value objects and arrays left unparsed until they're accessed, the buffer must outlive them.
+	template<typename X> bool parse_json_lazy(const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	// Parses with json::value data placed in a memory resource such as an rpoco::arena, pointer targets stay on the heap.
+	template<typename X> bool parse_json(memory_resource &memory, const std::string &str, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	template<typename X> bool parse_json(memory_resource &memory, const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	// Parses into a long lived object with its vectors overwritten in place instead of appended to, so
+	// that parsing into the same object again doesn't need to allocate.
+	template<typename X> bool parse_json_reuse(std::istream &in, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	template<typename X> bool parse_json_reuse(const std::string &str, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+	template<typename X> bool parse_json_reuse(const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true);
 	
 	// A function to convert an RPOCO compatible structure to a JSON string.
 	template<typename X> std::string to_json(X &x);
+	// Writes an RPOCO compatible structure as JSON while it's produced, through a buffer of about
+	// buffer_size bytes, to a stream, a file descriptor or a sink callback returning false to stop.
+	template<typename X> bool write_json(std::ostream &os, X &x, size_t buffer_size = 64 * 1024);
+#ifndef _WIN32
+	template<typename X> bool write_json(int fd, X &x, size_t buffer_size = 64 * 1024);
+#endif
+	template<typename X> bool write_json(const std::function<bool(const char*, size_t)> &sink, X &x, size_t buffer_size = 64 * 1024);
 
 	namespace json {
+		class value;
+		struct entry;
+
+		// strings, arrays and objects of values are allocated after a header recording the memory
+		// resource they came from (nullptr for the global heap) and their size, so that they can be
+		// returned to it and grown from it.
+		struct block {
+			rpoco::memory_resource *memory;
+			size_t size;
+
+			static const size_t header = alignof(std::max_align_t) > 2 * sizeof(void*) ? alignof(std::max_align_t) : 2 * sizeof(void*);
+			static void* allocate(rpoco::memory_resource *memory, size_t size) {
+				char *p = (char*)(memory ? memory->allocate(header + size, alignof(std::max_align_t)) : ::operator new(header + size));
+				block *b = (block*)p;
+				b->memory = memory;
+				b->size = size;
+				return p + header;
+			}
+			static block* of(const void *data) {
+				return (block*)((char*)data - header);
+			}
+			static rpoco::memory_resource* memory_of(const void *data) {
+				return data ? of(data)->memory : nullptr;
+			}
+			static void release(void *data) {
+				if (!data)
+					return;
+				block *b = of(data);
+				if (b->memory)
+					b->memory->deallocate(b, header + b->size, alignof(std::max_align_t));
+				else
+					::operator delete(b);
+			}
+		};
+
+		// the elements of an array value, stored contiguously in a single block. Lives inside
+		// the value so it's only reached through value::array().
+		class array {
+			friend class value;
+			value *m_items;
+			uint32_t m_size;
+			uint32_t m_capacity;
+
+			void grow(size_t need);
+			void destroy();
+			void copy_from(const array &other);
+		public:
+			size_t size() const {
+				return m_size;
+			}
+			bool empty() const {
+				return !m_size;
+			}
+			value* begin() {
+				return m_items;
+			}
+			value* end();
+			value& operator[](size_t idx);
+			value& back();
+			void reserve(size_t capacity) {
+				grow(capacity);
+			}
+			// appends a null value to be filled in
+			value& emplace_back();
+			// appends a value constructed from the arguments
+			template<typename... A>
+			value& emplace_back(A&&... args);
+			void push_back(const value &v);
+			void push_back(value &&v);
+			void clear();
+		};
+
+		// the members of an object value, a flat array sorted by key. Lives inside the value
+		// so it's only reached through value::map().
+		// Objects with room for index_min members or more also keep a hash index after the
+		// members in their block, members added with operator[] are then appended and only
+		// sorted into place by sort().
+		class object {
+			friend class value;
+			enum {
+				index_min = 32
+			};
+			entry *m_items;
+			uint32_t m_size;
+			uint32_t m_capacity;
+
+			static bool indexed(size_t capacity) {
+				return capacity >= index_min;
+			}
+			// the hash slots of an indexed object, a power of two at least twice the capacity
+			static size_t slots(size_t capacity) {
+				size_t count = 1;
+				while (count < capacity * 2)
+					count *= 2;
+				return count;
+			}
+			// the size of the block for a capacity, indexed objects store how many of their
+			// members are sorted followed by the slots (holding member positions + 1).
+			static size_t block_size(size_t capacity);
+			uint32_t* index() const;
+			void reindex(uint32_t sorted);
+			uint32_t* slot(const char *key, size_t len) const;
+			void grow(size_t need);
+			void destroy();
+			void copy_from(const object &other);
+			size_t lower_bound(const char *key, size_t len) const;
+			// parsed members are appended and sorted once the object is complete
+			value& append(const char *key, size_t len);
+			// fills positions with the member positions ordered by key, ties by position
+			void order(uint32_t *positions) const;
+		public:
+			size_t size() const {
+				return m_size;
+			}
+			bool empty() const {
+				return !m_size;
+			}
+			// false while members added with operator[] to an indexed object are unsorted
+			bool sorted() const {
+				return !indexed(m_capacity) || index()[0] == m_size;
+			}
+			// sorts appended members into place, this moves members so it invalidates references
+			void sort();
+			// iteration never moves members, unsorted members come last in the order they were added
+			entry* begin();
+			entry* end();
+			const entry* begin() const;
+			const entry* end() const;
+			// the value of a member or nullptr
+			value* find(const char *key, size_t len);
+			value* find(const std::string &key) {
+				return find(key.data(), key.size());
+			}
+			bool has(const std::string &key) {
+				return find(key) != nullptr;
+			}
+			// the value of a member, a null member is inserted if it's missing.
+			value& operator[](const std::string &key);
+			// sets a member to a value constructed from the arguments
+			template<typename... A>
+			value& emplace(const std::string &key, A&&... args);
+		};
+
 		// A generic catch-all class that can have any kind of JSON data.
 		// Useful for parsing arbitrary JSON data but also used for
 		// "extra" fields in RPOCO data.
+		// Short strings are stored inline and arrays and objects are flat arrays
+		// in a single block so that a value takes 24 bytes and little else.
 		class value {
-			rpoco::visit_type m_type;
+			friend class json::array;
+			friend class json::object;
+			enum {
+				small_max = 16,
+				long_string = 0xff
+			};
 			union {
 				bool b;
 				double n;
-				std::string *s;
-				std::vector<value> *a;
-				std::map<std::string, value> *o;
+				// inline strings
+				char small[small_max];
+				// longer strings, the length is the size of their block
+				char *s;
+				json::array a;
+				json::object o;
+				// lazily parsed objects and arrays keep their unparsed text until they're accessed
+				struct {
+					const char *text;
+					size_t size;
+				} raw;
 			}data;
+			uint8_t m_type;
+			// the length of inline strings or long_string
+			uint8_t m_small;
+			bool m_lazy;
+
+			void materialize();
+			// makes this a lazy object or array without checking the text, options are kept in m_small.
+			void refer_lazy(rpoco::visit_type toType, const char *text, size_t size, unsigned options) {
+				release();
+				m_type = toType;
+				m_lazy = true;
+				m_small = (uint8_t)options;
+				data.raw.text = text;
+				data.raw.size = size;
+			}
+			void consume_members(visitor &v);
+			void consume_elements(visitor &v);
+			// frees the contents, leaving a null value
+			void release() {
+				if (m_lazy) {
+					m_lazy = false;
+				} else {
+					switch (m_type) {
+					case rpoco::vt_string:
+						if (m_small == long_string)
+							block::release(data.s);
+						break;
+					case rpoco::vt_array:
+						data.a.destroy();
+						break;
+					case rpoco::vt_object:
+						data.o.destroy();
+						break;
+					}
+				}
+				m_type = rpoco::vt_null;
+			}
+			// takes over the contents of other leaving it null, values have no pointers to
+			// themselves so they're moved bitwise.
+			void take(value &other) {
+				release();
+				memcpy((void*)this, (const void*)&other, sizeof(value));
+				other.m_type = rpoco::vt_null;
+				other.m_lazy = false;
+			}
 			void copy_from(const value &other) {
-				set_type(other.m_type);
+				if (other.m_lazy) {
+					refer_lazy((rpoco::visit_type)other.m_type, other.data.raw.text, other.data.raw.size, other.m_small);
+					return;
+				}
 				switch (other.m_type) {
 				case rpoco::vt_array:
-					*data.a = *other.data.a;
+					set_type(rpoco::vt_array);
+					data.a.copy_from(other.data.a);
 					break;
 				case rpoco::vt_object:
-					*data.o = *other.data.o;
+					set_type(rpoco::vt_object);
+					data.o.copy_from(other.data.o);
 					break;
 				case rpoco::vt_string:
-					*data.s = *other.data.s;
+					set_string(other.string_data(), other.string_size());
 					break;
 				case rpoco::vt_bool:
-					data.b = other.data.b;
+					*this = other.data.b;
 					break;
 				case rpoco::vt_number:
-					data.n = other.data.n;
+					*this = other.data.n;
 					break;
+				default:
+					set_null();
 				}
 			}
 		public:
+			// the parser options lazy text was accepted with, it's parsed with the same ones later on.
+			enum {
+				lazy_comments = 1,
+				lazy_utf16_to_utf8 = 2
+			};
 			value() {
 				m_type = rpoco::vt_null;
+				m_lazy = false;
 			}
 			value(double v) {
 				m_type = rpoco::vt_number;
+				m_lazy = false;
+				data.n = v;
+			}
+			value(int v) {
+				m_type = rpoco::vt_number;
+				m_lazy = false;
 				data.n = v;
 			}
+			value(bool v) {
+				m_type = rpoco::vt_bool;
+				m_lazy = false;
+				data.b = v;
+			}
+			value(const char *str) {
+				m_type = rpoco::vt_null;
+				m_lazy = false;
+				set_string(str, strlen(str));
+			}
+			value(const std::string &str) {
+				m_type = rpoco::vt_null;
+				m_lazy = false;
+				set_string(str.data(), str.size());
+			}
 			value(const value &other) {
 				m_type = rpoco::vt_null;
+				m_lazy = false;
 				copy_from(other);
 			}
+			// moves leave the other value null
+			value(value &&other) noexcept {
+				m_type = rpoco::vt_null;
+				m_lazy = false;
+				take(other);
+			}
 			value& operator=(const value &other) {
-				copy_from(other);
+				// other might be a part of this value
+				value tmp(other);
+				take(tmp);
+				return *this;
+			}
+			value& operator=(value &&other) noexcept {
+				value tmp(std::move(other));
+				take(tmp);
 				return *this;
 			}
 			void set_null() {
@@ -91,13 +393,37 @@ namespace rpoco {
 				data.b = b;
 				return *this;
 			}
-			value& operator=(std::string s) {
-				set_type(rpoco::vt_string);
-				*data.s = s;
+			value& operator=(int i) {
+				return *this = (double)i;
+			}
+			value& operator=(const std::string &s) {
+				set_string(s.data(), s.size());
+				return *this;
+			}
+			value& operator=(const char *s) {
+				set_string(s, strlen(s));
 				return *this;
 			}
+			// assigns a string, long strings are allocated in memory when given.
+			void set_string(const char *str, size_t len, rpoco::memory_resource *memory = nullptr) {
+				// the string might be our own
+				if (len <= small_max) {
+					char tmp[small_max];
+					memcpy(tmp, str, len);
+					release();
+					memcpy(data.small, tmp, len);
+					m_small = (uint8_t)len;
+				} else {
+					char *s = (char*)block::allocate(memory, len);
+					memcpy(s, str, len);
+					release();
+					data.s = s;
+					m_small = long_string;
+				}
+				m_type = rpoco::vt_string;
+			}
 			rpoco::visit_type type() {
-				return m_type;
+				return (rpoco::visit_type)m_type;
 			}
 			bool to_bool() {
 				if (m_type == rpoco::vt_bool) {
@@ -127,77 +453,509 @@ namespace rpoco {
 					return 0;
 				}
 			}
+			// the characters of a string value (not null terminated)
+			const char* string_data() const {
+				if (m_type != rpoco::vt_string)
+					return "";
+				return m_small == long_string ? data.s : data.small;
+			}
+			size_t string_size() const {
+				if (m_type != rpoco::vt_string)
+					return 0;
+				return m_small == long_string ? block::of(data.s)->size : m_small;
+			}
 			std::string to_string() {
-				if (m_type == rpoco::vt_string) {
-					return *data.s;
-				} else {
-					return std::string("");
-				}
+				return std::string(string_data(), string_size());
 			}
-			std::map<std::string, rpoco::json::value>* map() {
+			// the members of an object. This returned a std::map<std::string,value> before
+			// objects were stored flat, json::object has the same size(), find(), operator[]
+			// and iteration but find() returns the value or nullptr and members are entries
+			// with key and val instead of pairs with first and second.
+			// Unlike a map, adding a member with operator[] or emplace() can move the other
+			// members and invalidates pointers and references into the object, as does sort().
+			// find(), iteration and writing never move members. Parsed objects are sorted by
+			// key, objects with index_min members or more iterate members added afterwards last
+			// until sort() is called.
+			json::object* map() {
+				if (m_lazy)
+					materialize();
 				if (m_type != rpoco::vt_object)
 					return 0;
-				return data.o;
+				return &data.o;
 			}
 			bool has(const std::string & key) {
+				if (m_lazy)
+					materialize();
 				if (m_type != rpoco::vt_object)
 					return false;
-				auto it = data.o->find(key);
-				return it != data.o->end();
+				return data.o.has(key);
 			}
 			value& operator[](const std::string & key) {
+				if (m_lazy)
+					materialize();
 				if (m_type != rpoco::vt_object)
 					return *(value*)nullptr;
-				return (*data.o)[key];
+				return data.o[key];
 			}
-			std::vector<rpoco::json::value>* array() {
+			json::array* array() {
+				if (m_lazy)
+					materialize();
 				if (m_type != rpoco::vt_array)
 					return 0;
-				return data.a;
+				return &data.a;
 			}
 			value& operator[](int idx) {
+				if (m_lazy)
+					materialize();
 				if (m_type != rpoco::vt_array)
 					return *(value*)nullptr;
-				return (*data.a)[idx];
+				return data.a[idx];
 			}
-			void set_type(rpoco::visit_type toType) {
-				if (m_type != toType) {
-					switch (m_type) {
-					case rpoco::vt_string:
-						delete data.s;
-						break;
-					case rpoco::vt_array:
-						delete data.a;
-						break;
-					case rpoco::vt_object:
-						delete data.o;
-						break;
-					}
-					switch (toType) {
-					case rpoco::vt_array:
-						data.a = new std::vector<value>();
-						break;
-					case rpoco::vt_object:
-						data.o = new std::map<std::string, value>();
-						break;
-					case rpoco::vt_string:
-						data.s = new std::string();
-						break;
-					case rpoco::vt_number:
-						data.n = 0;
-						break;
-					case rpoco::vt_bool:
-						data.b = false;
-						break;
-					}
+			// is this an object or array that hasn't been parsed yet?
+			bool lazy() {
+				return m_lazy;
+			}
+			// makes this an object or array that is parsed from the JSON text on first access, the
+			// text must outlive the value (and any copies of it). The text is validated right away,
+			// if it isn't an object or array of the type the value is left null and false returned.
+			bool set_lazy(rpoco::visit_type toType, const char *text, size_t size, bool allow_c_comments = false, bool utf16_to_utf8 = true);
+			// changes the type, new arrays and objects are allocated in memory when given.
+			void set_type(rpoco::visit_type toType, rpoco::memory_resource *memory = nullptr) {
+				if (m_type == toType && !m_lazy)
+					return;
+				release();
+				switch (toType) {
+				case rpoco::vt_array:
+					// the block remembers the memory to grow from
+					data.a.m_items = memory ? (value*)block::allocate(memory, 0) : nullptr;
+					data.a.m_size = data.a.m_capacity = 0;
+					break;
+				case rpoco::vt_object:
+					data.o.m_items = memory ? (entry*)block::allocate(memory, 0) : nullptr;
+					data.o.m_size = data.o.m_capacity = 0;
+					break;
+				case rpoco::vt_string:
+					m_small = 0;
+					break;
+				case rpoco::vt_number:
+					data.n = 0;
+					break;
+				case rpoco::vt_bool:
+					data.b = false;
+					break;
+				default:
+					// null has no data
+					break;
 				}
 				m_type = toType;
 			}
+			// builders that make the value an array or object first if it isn't one, the
+			// arguments construct the new element or member value.
+			template<typename... A>
+			value& emplace_back(A&&... args);
+			template<typename... A>
+			value& emplace(const std::string &key, A&&... args);
+			// reads the value from a visitor that is consuming data
+			void consume(visitor &v);
+			// writes the value to a visitor that is producing data
+			void produce(visitor &v);
 			~value() {
-				set_type(rpoco::vt_null);
+				release();
 			}
 		};
 
+		// an object member
+		struct entry {
+			value key;
+			value val;
+		};
+
+		inline value* array::end() {
+			return m_items + m_size;
+		}
+		inline value& array::operator[](size_t idx) {
+			return m_items[idx];
+		}
+		inline value& array::back() {
+			return m_items[m_size - 1];
+		}
+		inline void array::grow(size_t need) {
+			if (need <= m_capacity)
+				return;
+			size_t capacity = m_capacity ? m_capacity * 2 : 4;
+			if (capacity < need)
+				capacity = need;
+			value *items = (value*)block::allocate(block::memory_of(m_items), capacity * sizeof(value));
+			// values are moved bitwise
+			if (m_size)
+				memcpy((void*)items, (const void*)m_items, m_size * sizeof(value));
+			block::release(m_items);
+			m_items = items;
+			m_capacity = (uint32_t)capacity;
+		}
+		inline value& array::emplace_back() {
+			grow(m_size + 1);
+			value *v = new (m_items + m_size) value();
+			m_size++;
+			return *v;
+		}
+		template<typename... A>
+		inline value& array::emplace_back(A&&... args) {
+			// the arguments might refer to elements of this array
+			value tmp(std::forward<A>(args)...);
+			value &v = emplace_back();
+			v.take(tmp);
+			return v;
+		}
+		inline void array::push_back(const value &v) {
+			emplace_back(v);
+		}
+		inline void array::push_back(value &&v) {
+			emplace_back(std::move(v));
+		}
+		inline void array::clear() {
+			for (uint32_t i = 0;i < m_size;i++)
+				m_items[i].~value();
+			m_size = 0;
+		}
+		inline void array::destroy() {
+			clear();
+			block::release(m_items);
+			m_items = nullptr;
+			m_capacity = 0;
+		}
+		inline void array::copy_from(const array &other) {
+			grow(other.m_size);
+			for (uint32_t i = 0;i < other.m_size;i++)
+				new (m_items + i) value(other.m_items[i]);
+			m_size = other.m_size;
+		}
+
+		inline int compare_key(value &key, const char *str, size_t len) {
+			size_t size = key.string_size();
+			int c = memcmp(key.string_data(), str, size < len ? size : len);
+			if (c)
+				return c;
+			return size < len ? -1 : size > len ? 1 : 0;
+		}
+		inline size_t object::block_size(size_t capacity) {
+			return capacity * sizeof(entry) + (indexed(capacity) ? (slots(capacity) + 1) * sizeof(uint32_t) : 0);
+		}
+		inline uint32_t* object::index() const {
+			return (uint32_t*)(m_items + m_capacity);
+		}
+		inline entry* object::begin() {
+			return m_items;
+		}
+		inline entry* object::end() {
+			return m_items + m_size;
+		}
+		inline const entry* object::begin() const {
+			return m_items;
+		}
+		inline const entry* object::end() const {
+			return m_items + m_size;
+		}
+		inline uint32_t hash_key(const char *key, size_t len) {
+			uint32_t h = 2166136261u;
+			for (size_t i = 0;i < len;i++)
+				h = (h ^ (uint8_t)key[i]) * 16777619u;
+			return h;
+		}
+		// the slot holding a key in an indexed object or the empty slot where it belongs
+		inline uint32_t* object::slot(const char *key, size_t len) const {
+			uint32_t *table = index() + 1;
+			size_t mask = slots(m_capacity) - 1;
+			for (size_t i = hash_key(key, len) & mask;;i = (i + 1) & mask) {
+				if (!table[i] || !compare_key(m_items[table[i] - 1].key, key, len))
+					return table + i;
+			}
+		}
+		inline void object::reindex(uint32_t sorted) {
+			uint32_t *idx = index();
+			idx[0] = sorted;
+			memset(idx + 1, 0, slots(m_capacity) * sizeof(uint32_t));
+			for (uint32_t i = 0;i < m_size;i++)
+				*slot(m_items[i].key.string_data(), m_items[i].key.string_size()) = i + 1;
+		}
+		inline void object::grow(size_t need) {
+			if (need <= m_capacity)
+				return;
+			size_t capacity = m_capacity ? m_capacity * 2 : 4;
+			if (capacity < need)
+				capacity = need;
+			// smaller objects are always kept sorted
+			uint32_t sorted = indexed(m_capacity) ? index()[0] : m_size;
+			entry *items = (entry*)block::allocate(block::memory_of(m_items), block_size(capacity));
+			if (m_size)
+				memcpy((void*)items, (const void*)m_items, m_size * sizeof(entry));
+			block::release(m_items);
+			m_items = items;
+			m_capacity = (uint32_t)capacity;
+			if (indexed(m_capacity))
+				reindex(sorted);
+		}
+		inline void object::destroy() {
+			for (uint32_t i = 0;i < m_size;i++)
+				m_items[i].~entry();
+			block::release(m_items);
+			m_items = nullptr;
+			m_size = m_capacity = 0;
+		}
+		inline void object::copy_from(const object &other) {
+			grow(other.m_size);
+			for (uint32_t i = 0;i < other.m_size;i++)
+				new (m_items + i) entry(other.m_items[i]);
+			m_size = other.m_size;
+			if (indexed(m_capacity))
+				reindex(indexed(other.m_capacity) ? other.index()[0] : m_size);
+		}
+		inline size_t object::lower_bound(const char *key, size_t len) const {
+			size_t lo = 0, hi = m_size;
+			while (lo < hi) {
+				size_t mid = (lo + hi) / 2;
+				if (compare_key(m_items[mid].key, key, len) < 0)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			return lo;
+		}
+		inline value* object::find(const char *key, size_t len) {
+			if (indexed(m_capacity)) {
+				uint32_t *s = slot(key, len);
+				return *s ? &m_items[*s - 1].val : nullptr;
+			}
+			size_t i = lower_bound(key, len);
+			if (i < m_size && !compare_key(m_items[i].key, key, len))
+				return &m_items[i].val;
+			return nullptr;
+		}
+		inline value& object::operator[](const std::string &key) {
+			if (indexed(m_capacity)) {
+				// new members go last so that building a large object stays linear
+				uint32_t *s = slot(key.data(), key.size());
+				if (*s)
+					return m_items[*s - 1].val;
+				if (m_size == m_capacity) {
+					grow(m_size + 1);
+					s = slot(key.data(), key.size());
+				}
+				entry *e = new (m_items + m_size) entry();
+				e->key.set_string(key.data(), key.size(), block::memory_of(m_items));
+				*s = ++m_size;
+				return e->val;
+			}
+			size_t i = lower_bound(key.data(), key.size());
+			if (i < m_size && !compare_key(m_items[i].key, key.data(), key.size()))
+				return m_items[i].val;
+			grow(m_size + 1);
+			if (indexed(m_capacity))
+				return (*this)[key];
+			memmove((void*)(m_items + i + 1), (const void*)(m_items + i), (m_size - i) * sizeof(entry));
+			entry *e = new (m_items + i) entry();
+			e->key.set_string(key.data(), key.size(), block::memory_of(m_items));
+			m_size++;
+			return e->val;
+		}
+		template<typename... A>
+		inline value& object::emplace(const std::string &key, A&&... args) {
+			value tmp(std::forward<A>(args)...);
+			value &v = (*this)[key];
+			v.take(tmp);
+			return v;
+		}
+		template<typename... A>
+		inline value& value::emplace_back(A&&... args) {
+			value tmp(std::forward<A>(args)...);
+			if (m_lazy)
+				materialize();
+			if (m_type != rpoco::vt_array)
+				set_type(rpoco::vt_array);
+			return data.a.emplace_back(std::move(tmp));
+		}
+		template<typename... A>
+		inline value& value::emplace(const std::string &key, A&&... args) {
+			value tmp(std::forward<A>(args)...);
+			if (m_lazy)
+				materialize();
+			if (m_type != rpoco::vt_object)
+				set_type(rpoco::vt_object);
+			return data.o.emplace(key, std::move(tmp));
+		}
+		inline value& object::append(const char *key, size_t len) {
+			grow(m_size + 1);
+			entry *e = new (m_items + m_size) entry();
+			e->key.set_string(key, len, block::memory_of(m_items));
+			m_size++;
+			return e->val;
+		}
+		inline void object::order(uint32_t *positions) const {
+			for (uint32_t i = 0;i < m_size;i++)
+				positions[i] = i;
+			entry *items = m_items;
+			std::sort(positions, positions + m_size, [items](uint32_t l, uint32_t r) {
+				int c = compare_key(items[l].key, items[r].key.string_data(), items[r].key.string_size());
+				return c ? c < 0 : l < r;
+			});
+		}
+		inline void object::sort() {
+			bool sorted = true;
+			for (uint32_t i = 1;sorted && i < m_size;i++)
+				sorted = compare_key(m_items[i - 1].key, m_items[i].key.string_data(), m_items[i].key.string_size()) < 0;
+			if (sorted) {
+				if (indexed(m_capacity))
+					reindex(m_size);
+				return;
+			}
+			// an index is sorted so that the members are only moved once, ties are ordered by
+			// position so that later duplicates replace earlier ones like they would in a map.
+			uint32_t local[32];
+			std::vector<uint32_t> heap;
+			uint32_t *order = local;
+			if (m_size > 32) {
+				heap.resize(m_size);
+				order = heap.data();
+			}
+			this->order(order);
+			entry *items = m_items;
+			entry *sorted_items = (entry*)block::allocate(block::memory_of(m_items), block_size(m_capacity));
+			uint32_t count = 0;
+			for (uint32_t i = 0;i < m_size;i++) {
+				entry &e = items[order[i]];
+				if (i + 1 < m_size && !compare_key(items[order[i + 1]].key, e.key.string_data(), e.key.string_size())) {
+					e.~entry();
+					continue;
+				}
+				memcpy((void*)(sorted_items + count++), (const void*)&e, sizeof(entry));
+			}
+			block::release(m_items);
+			m_items = sorted_items;
+			m_size = count;
+			if (indexed(m_capacity))
+				reindex(m_size);
+		}
+
+		// the members and elements are collected through a single pointer so that the
+		// std::function holding the callback doesn't allocate.
+		inline void value::consume_members(visitor &v) {
+			struct filling {
+				value *self;
+				visitor *v;
+			} f = { this, &v };
+			v.consume_map([&f](const std::string &key) {
+				f.self->data.o.append(key.data(), key.size()).consume(*f.v);
+			});
+			data.o.sort();
+		}
+		inline void value::consume_elements(visitor &v) {
+			struct filling {
+				value *self;
+				visitor *v;
+			} f = { this, &v };
+			v.consume_array([&f]() {
+				f.self->data.a.emplace_back().consume(*f.v);
+			});
+		}
+		inline void value::consume(visitor &v) {
+			rpoco::memory_resource *memory = v.resource();
+			switch (v.peek()) {
+			case vt_null: {
+				v.visit_null();
+				set_null();
+			} break;
+			case vt_number: {
+				double d;
+				v.visit(d);
+				*this = d;
+			} break;
+			case vt_bool: {
+				bool b;
+				v.visit(b);
+				*this = b;
+			} break;
+			case vt_string: {
+				// strings are copied straight from the input when possible
+				rpoco::string_ref s;
+				v.visit(s);
+				set_string(s.data(), s.size(), memory);
+			} break;
+			case vt_object: {
+				rpoco::string_ref raw;
+				unsigned options;
+				if (v.capture(raw, options)) {
+					refer_lazy(rpoco::vt_object, raw.data(), raw.size(), options);
+					break;
+				}
+				set_type(rpoco::vt_object, memory);
+				consume_members(v);
+			} break;
+			case vt_array: {
+				rpoco::string_ref raw;
+				unsigned options;
+				if (v.capture(raw, options)) {
+					refer_lazy(rpoco::vt_array, raw.data(), raw.size(), options);
+					break;
+				}
+				set_type(rpoco::vt_array, memory);
+				consume_elements(v);
+			} break;
+			default:
+				// the visitor has failed or is only querying, the value is left as it was
+				break;
+			}
+		}
+		inline void value::produce(visitor &v) {
+			if (m_lazy)
+				materialize();
+			switch (m_type) {
+			case vt_null: {
+				v.visit_null();
+			} break;
+			case vt_number: {
+				double d = data.n;
+				v.visit(d);
+			} break;
+			case vt_bool: {
+				bool b = data.b;
+				v.visit(b);
+			} break;
+			case vt_string: {
+				rpoco::string_ref s(string_data(), string_size());
+				v.visit(s);
+			} break;
+			case vt_object: {
+				v.produce_start(rpoco::vt_object);
+				// unsorted members are written in key order without moving them
+				std::vector<uint32_t> order;
+				if (!data.o.sorted()) {
+					order.resize(data.o.size());
+					data.o.order(order.data());
+				}
+				for (uint32_t i = 0;i < data.o.size();i++) {
+					if (v.stopped())
+						break;
+					entry &e = data.o.m_items[order.empty() ? i : order[i]];
+					rpoco::string_ref key(e.key.string_data(), e.key.string_size());
+					v.visit(key);
+					e.val.produce(v);
+				}
+				v.produce_end(rpoco::vt_object);
+			} break;
+			case vt_array: {
+				v.produce_start(rpoco::vt_array);
+				for (value &e : data.a) {
+					if (v.stopped())
+						break;
+					e.produce(v);
+				}
+				v.produce_end(rpoco::vt_array);
+			} break;
+			default:
+				abort();
+			}
+		}
+
 	} // end of namespace rpoco::json for the value declaration
 
 
@@ -224,23 +982,23 @@ namespace rpoco {
 
 		virtual void all(std::function<void(const std::string&, query&)> out) {
 			if (auto map = v->map()) {
-				for (auto pair : *map) {
-					auto mq = make_query(pair.second);
-					out(pair.first, mq);
+				for (auto &e : *map) {
+					auto mq = make_query(e.val);
+					out(e.key.to_string(), mq);
 				}
 			}
 		}
 		virtual bool find(const std::string & name, std::function<void(query&)> out) {
 			if (auto map = v->map()) {
-				auto it = map->find(name);
-				if (it == map->end())
+				auto found = map->find(name);
+				if (!found)
 					return false;
-				auto mq = make_query(it->second);
+				auto mq = make_query(*found);
 				out(mq);
 			}
 			return false;
 		}
-		virtual void add(std::string & name, std::function<void(query&)>) {}
+		virtual void add(std::string & /*name*/, std::function<void(query&)>) {}
 
 		virtual void all(std::function<void(int, query&)> out) {
 			if (auto arr = v->array()) {
@@ -269,7 +1027,7 @@ namespace rpoco {
 			return nullptr;
 		}
 		virtual void set(const char *) {}
-		virtual void set(std::string &k) {}
+		virtual void set(std::string &/*k*/) {}
 		virtual std::string get() { return ""; }
 	};
 
@@ -277,77 +1035,10 @@ namespace rpoco {
 	// it to work coherently with the rest of the rpoco types.
 	template<> struct visit<rpoco::json::value> {
 		visit(visitor &v, rpoco::json::value &jv) {
-			if (v.peek() == vt_none) {
-				switch (jv.type()) {
-				case vt_null: {
-					v.visit_null();
-				} break;
-				case vt_number: {
-					double d = jv.to_number();
-					v.visit(d);
-				} break;
-				case vt_bool: {
-					bool b = jv.to_bool();
-					v.visit(b);
-				} break;
-				case vt_string: {
-					std::string str = jv.to_string();
-					v.visit(str);
-				} break;
-				case vt_object:
-					visit<std::map<std::string, rpoco::json::value>>(v, *jv.map());
-					//v.produce_start(rpoco::vt_object);
-					//jv.object_items([&v](std::string &n,rpocojson::json::value &sv){
-					//	v.visit(n);
-					//	visit(v,sv);
-					//});
-					//v.produce_end(rpoco::vt_array);
-					break;
-				case vt_array: {
-					visit<std::vector<rpoco::json::value>>(v, *jv.array());
-					//std::string tmp("");
-					//v.produce_start(rpoco::vt_object);
-					//jv.array_items([&v,&tmp](int idx,rpocojson::json::value &sv){
-					//	v.visit(tmp);
-					//	visit(v,sv);
-					//});
-					//v.produce_end(rpoco::vt_array);
-				} break;
-				default:
-					abort();
-				}
-				return;
-			} else {
-				switch (v.peek()) {
-				case vt_null: {
-					v.visit_null();
-					jv.set_null();
-				} break;
-				case vt_number: {
-					double d;
-					v.visit(d);
-					jv = d;
-				} break;
-				case vt_bool: {
-					bool b;
-					v.visit(b);
-					jv = b;
-				} break;
-				case vt_string: {
-					std::string s;
-					v.visit(s);
-					jv = s;
-				} break;
-				case vt_object: {
-					jv.set_type(rpoco::vt_object);
-					rpoco::visit<std::map<std::string, rpoco::json::value>>(v, *jv.map());
-				} break;
-				case vt_array: {
-					jv.set_type(rpoco::vt_array);
-					rpoco::visit<std::vector<rpoco::json::value>>(v, *jv.array());
-				} break;
-				}
-			}
+			if (v.peek() == vt_none)
+				jv.produce(v);
+			else
+				jv.consume(v);
 		}
 	};
 
@@ -368,7 +1059,7 @@ namespace rpoco {
 			friend class rpoco::field;
 
 			// the existence of this function forces all the types in this functions arguments to exist as attributes inside the type_info for the type
-			void rpoco_link_type_info_attributes(json_typeinfo & ti) {}
+			void rpoco_link_type_info_attributes(json_typeinfo & /*ti*/) {}
 
 			std::function<void(visitor &v,void *owner, const std::string &key)> consume_extra;
 			std::function<void(visitor &v, void *obj)> produce_extra;
@@ -385,6 +1076,8 @@ namespace rpoco {
 				produce_extra = [arg](visitor &v, void *obj) {
 					T* mappy = (T*)((std::ptrdiff_t)obj + (std::ptrdiff_t)arg->offset());
 					for (auto pair : *mappy) {
+						if (v.stopped())
+							break;
 						v.visit(const_cast<std::string&>(pair.first));
 						rpoco::visit<decltype(pair.second)>(v, pair.second);
 					}
@@ -397,7 +1090,7 @@ namespace rpoco {
 			// friend rpoco::field so that this class can register the need for json_typeinfo
 			template<typename T>
 			friend class rpoco::field;
-			void rpoco_link_type_info_attributes(json_typeinfo & ti) {}
+			void rpoco_link_type_info_attributes(json_typeinfo & /*ti*/) {}
 		};
 
 		// Aliases, controls the naming of fields marked with this.
@@ -409,15 +1102,215 @@ namespace rpoco {
 			// friend rpoco::field so that this class can register the need for json_typeinfo
 			template<typename T>
 			friend class rpoco::field;
-			void rpoco_link_type_info_attributes(json_typeinfo & ti) {}
+			void rpoco_link_type_info_attributes(json_typeinfo & /*ti*/) {}
 		public:
 			alias(const std::string & inv) :aliasname(inv) {}
 		};
 
+		// Stores vector fields of numbers (or bytes) as a base64 string of the little endian bytes of
+		// the elements instead of as an array, the way Tiled stores base64 layer data. Plain arrays
+		// are still accepted when parsing.
+		class base64 {
+			friend class json_typeinfo;
+
+			// friend rpoco::field so that this class can register the need for json_typeinfo
+			template<typename T>
+			friend class rpoco::field;
+			void rpoco_link_type_info_attributes(json_typeinfo & /*ti*/) {}
+
+			std::function<void(visitor &v, void *obj)> visit_field;
+
+			// this function only exists to signal that this class wants to initialize the field type
+			void rpoco_want_link_field_type() {}
+			template<typename T>
+			void rpoco_link_field_type(rpoco::field<T> * arg) {
+				std::ptrdiff_t offset = arg->offset();
+				visit_field = [offset](visitor &v, void *obj) {
+					visit_encoded(v, *(T*)((std::ptrdiff_t)obj + offset));
+				};
+			}
+
+			static bool little_endian() {
+				const uint16_t one = 1;
+				return *(const unsigned char*)&one == 1;
+			}
+			// elements are stored little endian whatever the host
+			template<typename F>
+			static void swap_elements(F *elements, size_t count) {
+				if (sizeof(F) == 1 || little_endian())
+					return;
+				for (size_t i = 0;i < count;i++) {
+					unsigned char *b = (unsigned char*)(elements + i);
+					std::reverse(b, b + sizeof(F));
+				}
+			}
+			template<typename F, typename A>
+			static void visit_encoded(visitor &v, std::vector<F, A> &vec) {
+				static_assert(std::is_arithmetic<F>::value, "base64 fields must be vectors of numbers");
+				rpoco::visit_type vt = v.peek();
+				if (vt == rpoco::vt_none) {
+					std::string text;
+					if (sizeof(F) == 1 || little_endian()) {
+						encode((const unsigned char*)vec.data(), vec.size() * sizeof(F), text);
+					} else {
+						std::vector<F> copy(vec.begin(), vec.end());
+						swap_elements(copy.data(), copy.size());
+						encode((const unsigned char*)copy.data(), copy.size() * sizeof(F), text);
+					}
+					v.visit(text);
+				} else if (vt == rpoco::vt_string) {
+					rpoco::string_ref text;
+					v.visit(text);
+					size_t size = decoded_size(text.data(), text.size());
+					if (size == (size_t)-1 || size % sizeof(F)) {
+						v.error("invalid base64 data");
+						return;
+					}
+					vec.resize(size / sizeof(F));
+					if (!decode(text.data(), text.size(), (unsigned char*)vec.data())) {
+						v.error("invalid base64 data");
+						return;
+					}
+					swap_elements(vec.data(), vec.size());
+				} else {
+					rpoco::visit<std::vector<F, A>>(v, vec);
+				}
+			}
+
+			static const char* alphabet() {
+				return "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			}
+			// character values, 0xff for characters outside of the alphabet
+			static const unsigned char* values() {
+				static const struct table {
+					unsigned char v[256];
+					table() {
+						memset(v, 0xff, sizeof(v));
+						for (int i = 0;i < 64;i++)
+							v[(unsigned char)alphabet()[i]] = (unsigned char)i;
+					}
+				} t;
+				return t.v;
+			}
+		public:
+			// appends the base64 encoding of size bytes to out, with = padding.
+			static void encode(const unsigned char *data, size_t size, std::string &out) {
+				size_t start = out.size();
+				out.resize(start + (size + 2) / 3 * 4);
+				char *o = &out[0] + start;
+				const char *chars = alphabet();
+				size_t i = 0;
+#if defined(__SSSE3__) || defined(__AVX2__)
+				// 12 bytes to 16 characters at a time (reading 16 bytes), see Wojciech Mula's base64 SIMD work
+				for (;i + 16 <= size;i += 12, o += 16) {
+					__m128i in = _mm_loadu_si128((const __m128i*)(data + i));
+					in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+					// split each 3 bytes into four 6 bit indices
+					__m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+					__m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+					__m128i idx = _mm_or_si128(t0, t1);
+					// offsets to the characters of each index range
+					__m128i range = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+					range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+					__m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+						'0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+					_mm_storeu_si128((__m128i*)o, _mm_add_epi8(_mm_shuffle_epi8(offsets, range), idx));
+				}
+#endif
+				for (;i + 3 <= size;i += 3, o += 4) {
+					uint32_t v = (uint32_t)data[i] << 16 | (uint32_t)data[i + 1] << 8 | data[i + 2];
+					o[0] = chars[v >> 18];
+					o[1] = chars[(v >> 12) & 63];
+					o[2] = chars[(v >> 6) & 63];
+					o[3] = chars[v & 63];
+				}
+				if (i < size) {
+					uint32_t v = (uint32_t)data[i] << 16 | (i + 1 < size ? (uint32_t)data[i + 1] << 8 : 0);
+					o[0] = chars[v >> 18];
+					o[1] = chars[(v >> 12) & 63];
+					o[2] = i + 1 < size ? chars[(v >> 6) & 63] : '=';
+					o[3] = '=';
+				}
+			}
+			// the number of bytes encoded by size characters of base64 text, (size_t)-1 if the text
+			// isn't a whole number of padded 4 character groups.
+			static size_t decoded_size(const char *text, size_t size) {
+				if (size % 4)
+					return (size_t)-1;
+				size_t bytes = size / 4 * 3;
+				for (size_t i = 0;i < 2 && size && text[size - 1 - i] == '=';i++)
+					bytes--;
+				return bytes;
+			}
+			// decodes the text to decoded_size bytes at out, returns false for invalid characters.
+			static bool decode(const char *text, size_t size, unsigned char *out) {
+				size_t bytes = decoded_size(text, size);
+				if (bytes == (size_t)-1)
+					return false;
+				const unsigned char *table = values();
+				size_t i = 0;
+#if defined(__SSSE3__) || defined(__AVX2__)
+				// 16 characters to 12 bytes at a time, the last group is left to the scalar code
+				// below since it may be padded.
+				for (;i + 20 <= size;i += 16, out += 12) {
+					__m128i in = _mm_loadu_si128((const __m128i*)(text + i));
+					__m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+					__m128i lo = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+					// the valid high nibbles for each low nibble
+					__m128i valid = _mm_setr_epi8((char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+						(char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54);
+					__m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0);
+					__m128i bad = _mm_cmpeq_epi8(_mm_and_si128(_mm_shuffle_epi8(valid, lo), _mm_shuffle_epi8(bits, hi)), _mm_setzero_si128());
+					if (_mm_movemask_epi8(bad))
+						return false;
+					// characters to 6 bit values, / shares its high nibble with + but has another offset
+					__m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+					__m128i shift = _mm_shuffle_epi8(_mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0), hi);
+					shift = _mm_or_si128(_mm_andnot_si128(slash, shift), _mm_and_si128(slash, _mm_set1_epi8(16)));
+					__m128i v = _mm_add_epi8(in, shift);
+					// pack four 6 bit values into 3 bytes
+					v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+					v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+					v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+					unsigned char tmp[16];
+					_mm_storeu_si128((__m128i*)tmp, v);
+					memcpy(out, tmp, 12);
+				}
+#endif
+				for (;i < size;i += 4) {
+					unsigned a = table[(unsigned char)text[i]], b = table[(unsigned char)text[i + 1]];
+					unsigned c = table[(unsigned char)text[i + 2]], d = table[(unsigned char)text[i + 3]];
+					// padding is only allowed at the end
+					bool last = i + 4 == size;
+					if (last && text[i + 3] == '=') {
+						d = 0;
+						if (text[i + 2] == '=')
+							c = 0;
+					}
+					if ((a | b | c | d) > 63)
+						return false;
+					uint32_t v = a << 18 | b << 12 | c << 6 | d;
+					size_t n = last ? bytes - (i / 4 * 3) : 3;
+					out[0] = (unsigned char)(v >> 16);
+					if (n > 1)
+						out[1] = (unsigned char)(v >> 8);
+					if (n > 2)
+						out[2] = (unsigned char)v;
+					out += 3;
+				}
+				return true;
+			}
+		};
+
 		// generic json_typeinfo (when parsing/generating rpoco types that have aliases , ignores and/or extra catchalls)
 		class json_typeinfo {
-			std::unordered_map<std::string, rpoco::member*> mappings;
+			// the JSON names and members in declaration order
+			std::vector<std::pair<std::string, rpoco::member*>> mappings;
+			rpoco::key_index index;
 			rpoco::json::extra *extra;
+			rpoco::member *extra_member;
+			// are any members base64 encoded?
+			bool encoded;
 
 			// friend the type_info type so that they can invoke our post-init function.
 			friend rpoco::type_info;
@@ -425,6 +1318,8 @@ namespace rpoco {
 				// rebuild mapping list
 				mappings.clear();
 				extra = nullptr;
+				extra_member = nullptr;
+				encoded = false;
 				for (int i = 0;i < ti.size();i++) {
 					auto memb = ti[i];
 					if (auto * ign = memb->attribute<ignore>()) {
@@ -432,23 +1327,70 @@ namespace rpoco {
 					}
 					if (auto * exatt= memb->attribute<rpoco::json::extra>()) {
 						extra = exatt;
+						extra_member = memb;
 						continue;
 					}
-					if (auto * aliasatt = memb->attribute<alias>()) {
-						mappings[aliasatt->aliasname] = memb;
-					} else {
-						mappings[memb->name()] = memb;
-					}
+					auto * aliasatt = memb->attribute<alias>();
+					mappings.emplace_back(aliasatt ? aliasatt->aliasname : memb->name(), memb);
+					if (memb->attribute<base64>())
+						encoded = true;
 				}
+				std::vector<std::string> names;
+				for (auto &mapping : mappings)
+					names.push_back(mapping.first);
+				index.build(names);
 			}
 		public:
+			// find the member mapped to a JSON name
+			rpoco::member* find(const char *key, size_t len) {
+				int idx = index.find(key, len);
+				return idx < 0 ? nullptr : mappings[idx].second;
+			}
+			// find with a hint about the position of the mapping, see key_index
+			rpoco::member* find(const char *key, size_t len, int &hint) {
+				int idx = index.find(key, len, hint);
+				return idx < 0 ? nullptr : mappings[idx].second;
+			}
+			// the number of mappings and the member of a mapping, in declaration order
+			int size() {
+				return (int)mappings.size();
+			}
+			rpoco::member* at(int idx) {
+				return mappings[idx].second;
+			}
+			// empties the extra field of a reused object before the members are parsed into it
+			void reset_extra(void *obj) {
+				if (extra_member)
+					extra_member->reset(obj);
+			}
+			// is there an extra field for the members that don't match any mapping?
+			bool has_extra() {
+				return this->extra != nullptr;
+			}
+			// consume a member that didn't match any mapping into the extra field, returns false if there is none
+			bool consume_extra(visitor &v, void *obj, const std::string &key) {
+				if (!this->extra)
+					return false;
+				this->extra->consume_extra(v, obj, key);
+				return true;
+			}
+			// visits a member of an object, base64 members are encoded
+			void visit(rpoco::member *memb, visitor &v, void *obj) {
+				rpoco::json::base64 *b64;
+				if (encoded && (b64 = memb->attribute<base64>()))
+					b64->visit_field(v, obj);
+				else
+					memb->visit(v, obj);
+			}
 			void produce_object(visitor &v, void *obj) {
 				v.produce_start(vt_object);
-				for (auto mapping : mappings) {
-					v.visit( const_cast<std::string&>(mapping.first));
-					mapping.second->visit(v, obj);
+				for (auto &mapping : mappings) {
+					if (v.stopped())
+						break;
+					v.visit(mapping.first);
+					visit(mapping.second, v, obj);
 				}
-				if (this->extra) {
+				if (this->extra && !v.stopped()) {
 					this->extra->produce_extra(v,obj);
 				}
 				v.produce_end(vt_object);
@@ -456,10 +1398,9 @@ namespace rpoco {
 			std::function<void(const std::string &)> make_map_consumer(visitor *v,void *obj,rpoco::member **mpp) {
 				return [this, v, obj,mpp](const std::string & key) {
 					rpoco::member *old = *mpp;
-					auto it = mappings.find(key);
-					if (it != mappings.end()) {
-						*mpp = it->second;
-						it->second->visit(*v, obj);
+					if (rpoco::member *memb = find(key.data(), key.size())) {
+						*mpp = memb;
+						visit(memb, *v, obj);
 						*mpp = old;
 						return;
 					}
@@ -477,11 +1418,17 @@ namespace rpoco {
 		// Select_info's holds the functionality to build specialized objects depending on the JSON data contents.
 		class select_info {
 			std::string keyname;
-			std::unordered_map<std::string, std::function<void*()>> selections;
+			// how to make and visit the type for each selector value
+			struct selection {
+				std::function<void*()> make;
+				rpoco::visit_fn visit;
+				const std::type_info *type;
+			};
+			std::unordered_map<std::string, selection> selections;
 			template<typename ...T> friend  select_info select(const char * selector);
 
 			template<typename T>
-			void expand_selections(const char *selector) {
+			void expand_selections(const char * /*selector*/) {
 			}
 			template<typename T, typename H, typename ...R>
 			void expand_selections(const char *selector) {
@@ -495,16 +1442,42 @@ namespace rpoco {
 				if (!pselval) {
 					throw std::runtime_error(std::string("selector ") + selector + " is not a string");
 				}
-				selections[*pselval] = []() { return new H(); };
+				selection &sel = selections[*pselval];
+				sel.make = []() -> void* { return new H(); };
+				sel.visit = [](visitor &v, void *obj) { rpoco::visit<H>(v, *(H*)obj); };
+				sel.type = &typeid(H);
 				expand_selections<T, R...>(selector);
 			}
 
 			template<typename ...T>
-			select_info(const char *selector, std::tuple<T...>* dummy) {
+			select_info(const char *selector, std::tuple<T...>* /*dummy*/) {
 				keyname = selector;
 				expand_selections<std::tuple<T...>, T...>(selector);
 			}
 		public:
+			// name of the field holding the selector
+			const std::string& key() {
+				return keyname;
+			}
+			// construct the type for a selector value, visit_as visits the object as that type
+			void* construct(const std::string &selector, rpoco::visit_fn &visit_as) {
+				auto si = selections.find(selector);
+				if (si == selections.end())
+					return nullptr;
+				visit_as = si->second.visit;
+				return si->second.make();
+			}
+			// the type for a selector value (or nullptr)
+			const std::type_info* type(const std::string &selector) {
+				auto si = selections.find(selector);
+				return si == selections.end() ? nullptr : si->second.type;
+			}
+			// the type for a selector value (or nullptr), visit_as visits an object of that type
+			const std::type_info* type(const std::string &selector, rpoco::visit_fn &visit_as) {
+				auto si = selections.find(selector);
+				visit_as = si == selections.end() ? nullptr : si->second.visit;
+				return si == selections.end() ? nullptr : si->second.type;
+			}
 			void* construct(value &v) {
 				// Do we have an object read in?
 				if (v.type() != vt_object)
@@ -514,16 +1487,16 @@ namespace rpoco {
 				// try to find the selector key
 				auto kv = mapping->find(keyname);
 				// if the selector key is not found then we can't build
-				if (kv == mapping->end())
+				if (!kv)
 					return nullptr;
 				// is it a string selector?
-				if (kv->second.type() == vt_string) {
+				if (kv->type() == vt_string) {
 					// if it's a string selector try to find a mapping to an actual type
-					auto si = selections.find(kv->second.to_string());
+					auto si = selections.find(kv->to_string());
 					if (si == selections.end())
 						return nullptr;
 					// a proper mapping found, make the object
-					return si->second();
+					return si->second.make();
 				} else {
 					return nullptr;
 				}
@@ -596,716 +1569,2249 @@ namespace rpoco {
 			return out;
 		}
 
-		// the public JSON parsing function
-		// X is the type of the RPOCO conforming target data type that will receive the root JSON data object.
-		// utf16 to utf8 translates utf16 surrogate pairs to utf8 codepoints
-		template<typename X> bool parse(std::istream &in, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
-			// an internal class with the actual logic acting as a rpoco visitor
-			struct json_parser : public rpoco::visitor {
-				// validity indicator, used for early exiting after errors
-				bool ok = true;
-				// the input
-				std::istream *ins;
-				// temporary string object used during various phases of the parsing
-				std::string tmp;
-				// allow C/C++ style comments within JSON literals
-				bool allow_c_comments;
-				// decode utf16 surrogates
-				bool utf16_to_utf8;
-				// current member we're working with.
-				rpoco::member * current_member = 0;
-
-				// constructor to take the options and input for the parser.
-				json_parser(std::istream &ins, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
-					this->ins = &ins;
-					this->allow_c_comments = allow_c_comments;
-					this->utf16_to_utf8 = utf16_to_utf8;
-				}
-				virtual void error(const std::string &err) {
-					ok = false;
-					abort();
+		// strings that can refer to the input buffer
+		using rpoco::string_ref;
+
+		// character classification helpers, JSON only recognizes 4 whitespace characters so
+		// these are both stricter and faster than the locale dependant std::isspace/std::isdigit.
+		inline bool is_space(int c) {
+			return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+		}
+		inline bool is_digit(int c) {
+			return (unsigned)(c - '0') < 10;
+		}
+
+		// A JSON number scanned by the parser, the significant digits are accumulated into the
+		// mantissa (as long as it doesn't overflow) and the text is kept so that numbers that can't
+		// be converted exactly by the fast paths below are handed to a correctly rounding (and
+		// locale independent) conversion.
+		class number {
+			char text[64]; // the characters of the number if it fits, otherwise long_text is used.
+			std::string long_text;
+			size_t length = 0;
+			int digits = 0; // significant digits seen
+			bool full = false; // the mantissa can't take more digits
+
+			const char* chars() const {
+				return length < sizeof(text) ? text : long_text.data();
+			}
+
+			// conversion of the text for numbers outside of the fast paths
+			template<typename T>
+			T convert_text(T(*strto)(const char*, char**)) const {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+				(void)strto; // only needed without from_chars
+				T v = 0;
+				if (std::from_chars(chars(), chars() + length, v).ec == std::errc::result_out_of_range) {
+					// the magnitude decides between overflow and underflow
+					v = exponent + digits > 0 ? std::numeric_limits<T>::infinity() : T(0);
+					if (negative)
+						v = -v;
 				}
+				return v;
+#else
+				// the strto functions are locale dependant so swap in the decimal point of the current locale
+				std::string tmp(chars(), length);
+				size_t dot = tmp.find('.');
+				if (dot != std::string::npos)
+					tmp.replace(dot, 1, localeconv()->decimal_point);
+				return strto(tmp.c_str(), nullptr);
+#endif
+			}
+			static float strtof_wrap(const char *s, char **e) {
+				return strtof(s, e);
+			}
+		public:
+			bool negative = false;
+			bool integer = true; // no fraction or exponent part present
+			bool truncated = false; // non-zero digits didn't fit the mantissa so it isn't exact
+			uint64_t mantissa = 0;
+			int exponent = 0; // power of ten to scale the mantissa with
 
-				// skip non-spaces (and comments if that is enabled)
-				void skip() {
-					while (ok) {
-						if (std::isspace(ins->peek())) {
-							ins->get();
-							continue;
+			// reads a number straight from a buffer in one go, returns false without reading anything
+			// if it has more significant digits than fit the mantissa or isn't followed by anything
+			// within the buffer, and for syntax errors (so that the regular scan can report them).
+			bool parse(const char *p, size_t avail, size_t &len) {
+				size_t i = 0;
+				if (i < avail && p[i] == '-') {
+					negative = true;
+					i++;
+				}
+				if (i < avail && p[i] == '0') {
+					i++;
+				} else if (i < avail && is_digit(p[i])) {
+					while (i < avail && is_digit(p[i])) {
+						mantissa = mantissa * 10 + (p[i++] - '0');
+						digits++;
+					}
+				} else {
+					return false;
+				}
+				if (i < avail && p[i] == '.') {
+					integer = false;
+					if (++i >= avail || !is_digit(p[i]))
+						return false;
+					while (i < avail && is_digit(p[i])) {
+						int d = p[i++] - '0';
+						// leading zeros of the fraction aren't significant
+						if (digits || d) {
+							mantissa = mantissa * 10 + d;
+							digits++;
 						}
-						if (allow_c_comments && ins->peek() == '/') {
-							ins->get(); // eat '/'
-							switch (ins->peek()) { // what kind of comment do we have
-							case '/':
-								// single line comment, eat until carriage return,linefeed or form feed
-								while (true) {
-									int c = ins->peek();
-									if (c == 13 || c == 10 || c == 12 || c == EOF) {
-										break;
-									} else {
-										ins->get();
-										continue;
-									}
-								}
-								continue;
-							case '*':
-								// multiline comment
-							{
-								ins->get(); // eat '*'
-								int last = 0;
-								while (ok) {
-									int c = ins->get();
-									if (c == EOF) {
-										// EOF inside comment leads to a syntax error.
-										ok = false;
-										break;
-									} else if (last == '*'&&c == '/') {
-										// end of multiline comment found.
-										break;
-									} else {
-										last = c;
-									}
-								}
-								if (ok)
-									continue;
-								break;
-							}
-							default:
-								// syntax error in JSON
-								ok = false;
-								break;
-							}
+						exponent--;
+					}
+				}
+				if (i < avail && (p[i] == 'e' || p[i] == 'E')) {
+					integer = false;
+					bool negative_exp = false;
+					if (++i < avail && (p[i] == '+' || p[i] == '-'))
+						negative_exp = p[i++] == '-';
+					if (i >= avail || !is_digit(p[i]))
+						return false;
+					int exp = 0;
+					while (i < avail && is_digit(p[i])) {
+						if (exp < 100000) // anything larger is out of range anyhow
+							exp = exp * 10 + (p[i] - '0');
+						i++;
+					}
+					exponent += negative_exp ? -exp : exp;
+				}
+				// 19 digits always fit the mantissa
+				if (i >= avail || digits > 19 || i >= sizeof(text))
+					return false;
+				memcpy(text, p, i);
+				length = i;
+				len = i;
+				return true;
+			}
+			void append(int c) {
+				if (length < sizeof(text) - 1) {
+					text[length] = (char)c;
+				} else {
+					if (length == sizeof(text) - 1)
+						long_text.assign(text, length);
+					long_text.push_back((char)c);
+				}
+				length++;
+			}
+			void add_digit(int c, bool fraction) {
+				append(c);
+				int d = c - '0';
+				if (!digits && !d) {
+					// leading zeros aren't significant
+					if (fraction)
+						exponent--;
+					return;
+				}
+				digits++;
+				if (!full && mantissa <= (UINT64_MAX - d) / 10) {
+					mantissa = mantissa * 10 + d;
+					if (fraction)
+						exponent--;
+				} else {
+					full = true;
+					if (d)
+						truncated = true;
+					if (!fraction)
+						exponent++;
+				}
+			}
+
+			double to_double() const {
+				if (!truncated) {
+					if (!mantissa)
+						return negative ? -0.0 : 0.0;
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0
+					// Clinger's fast path, both the mantissa and the power of ten are exact doubles so the
+					// result of a single multiplication or division is correctly rounded.
+					static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+						1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+					if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22 + 16) {
+						uint64_t m = mantissa;
+						int e = exponent;
+						// move excess exponent into the mantissa as long as it stays exact
+						while (e > 22 && m <= (1ULL << 53) / 10) {
+							m *= 10;
+							e--;
+						}
+						if (e <= 22) {
+							double d = e < 0 ? (double)m / powers[-e] : (double)m * powers[e];
+							return negative ? -d : d;
 						}
-						// not a comment
-						break;
 					}
+#endif
 				}
-				// production functions are invalid to be called by the visitor during parsing.
-				virtual void produce_start(rpoco::visit_type vt) {
-					abort(); // should not be called
-				}
-				// production functions are invalid to be called by the visitor during parsing.
-				virtual void produce_end(rpoco::visit_type vt) {
-					abort(); // should not be called
-				}
-				// the peek function hints at what kind of objects can be consumed.
-				virtual rpoco::visit_type peek() {
-					skip(); // skip any spaces and comments so we can identify the token based on the first character
-					// first check digits
-					if (std::isdigit(ins->peek()))
-						return rpoco::vt_number;
-					switch (ins->peek()) {
-					case '{': // object start
-						return rpoco::vt_object;
-					case '[': // array start
-						return rpoco::vt_array;
-					case '\"': // string start
-						return rpoco::vt_string;
-					case 't': // true start
-					case 'f': // false start
-						return rpoco::vt_bool;
-					case 'n': // null start
-						return rpoco::vt_null;
-					case '-': // negative number start
-						return rpoco::vt_number;
-					default: // invalid object start, stop parsing.
-						ok = false;
-						return rpoco::vt_error;
+				return convert_text<double>(strtod);
+			}
+			// converts the number to an integer type, fails if it's out of range or has a fraction.
+			template<typename I>
+			bool to_integer(I &out) const {
+				uint64_t m = mantissa;
+				if (truncated) {
+					// too many digits for the mantissa, check the range and fraction on a double instead
+					double d = to_double();
+					if (!(d >= (double)std::numeric_limits<I>::min() && d < (double)std::numeric_limits<I>::max() + 1.0))
+						return false;
+					I v = (I)d;
+					if ((double)v != d)
+						return false;
+					out = v;
+					return true;
+				}
+				if (exponent && m) {
+					int e = exponent;
+					for (;e < 0;e++) {
+						if (m % 10)
+							return false;
+						m /= 10;
+					}
+					for (;e > 0;e--) {
+						if (m > UINT64_MAX / 10)
+							return false;
+						m *= 10;
 					}
 				}
-				// a match function used to skip the remainder of known constants (null/true/false)
-				void match(const char *s) {
-					for (int i = 0;s[i];i++)
-						ok &= (ins->get() == s[i]);
+				if (negative && m) {
+					if (!std::numeric_limits<I>::is_signed || m - 1 > (uint64_t)std::numeric_limits<I>::max())
+						return false;
+					// written to avoid overflowing on the minimum value
+					out = (I)(-(I)(m - 1) - 1);
+				} else {
+					if (m > (uint64_t)std::numeric_limits<I>::max())
+						return false;
+					out = (I)m;
 				}
-				// null parsing
-				virtual void visit_null() {
-					skip();
-					match("null");
+				return true;
+			}
+			float to_float() const {
+				if (!truncated) {
+					if (!mantissa)
+						return negative ? -0.0f : 0.0f;
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0
+					// Clinger's fast path for single precision floats
+					static const float powers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+					if (mantissa <= (1ULL << 24) && exponent >= -10 && exponent <= 10) {
+						float f = exponent < 0 ? (float)mantissa / powers[-exponent] : (float)mantissa * powers[exponent];
+						return negative ? -f : f;
+					}
+#endif
 				}
-				virtual void* construct(std::type_index index) {
-					if (!current_member)
-						return nullptr;
-					select_info * info=current_member->attribute<rpoco::json::select_info>();
-					if (!info)
-						return nullptr;
-					auto pos = ins->tellg();
-					json_value jv;
-					rpoco::visit<json_value>(*this, jv);
-					ins->seekg(pos);
-					return info->construct(jv);
-				}
-				// object,map and array parsing functions ("consumption")
-				virtual bool consume_object(member_provider &mp,void *obj) {
-					// check if we have a json_typeinfo mapping that overrides the regular object layout.
-					if (auto jti = mp.attribute<json_typeinfo>()) {
-						// if so, use that to consume the object
-						return consume_map(jti->make_map_consumer(this, obj,&current_member));
+				return convert_text<float>(strtof_wrap);
+			}
+		};
+
+		// Scanning kernels that classify a 64 byte block of input at a time with AVX2 or SSE2
+		// when the compiler targets them (with a scalar fallback for other platforms) into
+		// bitmasks of whitespace, structural characters, quotes and backslashes.
+		namespace scan {
+			// bitmasks for a 64 byte block, bit N corresponds to byte N of the block
+			struct block {
+				uint64_t space;
+				uint64_t op;
+				uint64_t quote;
+				uint64_t backslash;
+			};
+
+			inline int trailing_zeroes(uint64_t bits) {
+#if defined(_MSC_VER) && defined(_WIN64)
+				unsigned long idx;
+				_BitScanForward64(&idx, bits);
+				return (int)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+				return __builtin_ctzll(bits);
+#else
+				int idx = 0;
+				while (!(bits & 1)) {
+					bits >>= 1;
+					idx++;
+				}
+				return idx;
+#endif
+			}
+
+			inline int leading_zeroes(uint64_t bits) {
+#if defined(_MSC_VER) && defined(_WIN64)
+				unsigned long idx;
+				_BitScanReverse64(&idx, bits);
+				return 63 - (int)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+				return __builtin_clzll(bits);
+#else
+				int idx = 0;
+				while (!(bits & (1ULL << 63))) {
+					bits <<= 1;
+					idx++;
+				}
+				return idx;
+#endif
+			}
+
+			// bit N becomes the parity of bits 0 to N, for a quote mask that marks the opening quotes
+			// and the bodies of the strings (but not the closing quotes).
+			inline uint64_t prefix_xor(uint64_t bits) {
+				bits ^= bits << 1;
+				bits ^= bits << 2;
+				bits ^= bits << 4;
+				bits ^= bits << 8;
+				bits ^= bits << 16;
+				bits ^= bits << 32;
+				return bits;
+			}
+
+			// classify 64 bytes (all must be readable) one at a time, the vector kernels below must
+			// give the same masks.
+			inline block classify_scalar(const char *p) {
+				block out;
+				out.space = out.op = out.quote = out.backslash = 0;
+				for (int i = 0;i < 64;i++) {
+					uint64_t bit = 1ULL << i;
+					switch (p[i]) {
+					case ' ': case '\t': case '\n': case '\r':
+						out.space |= bit;
+						break;
+					case '{': case '}': case '[': case ']': case ':': case ',':
+						out.op |= bit;
+						break;
+					case '"':
+						out.quote |= bit;
+						break;
+					case '\\':
+						out.backslash |= bit;
+						break;
 					}
-					// otherwise create a plain C++ mapping default
-					return consume_map([&](const std::string &key) {
-						// invoke the consumer function with the key to parse the rest
-						if (mp.has(key)) {
-							auto member = mp[key];
-							auto old_member = current_member;
-							current_member = member;
-							member->visit(*this, obj);
-							current_member = old_member;
-						} else {
-							visit_nil(*this);
-						}
-					});
 				}
-				virtual bool consume_map(const std::function<void(const std::string&)> &g) {
-					// JSON object
-					ok &= ins->get() == '{';
-					if (!ok) return true;
-					skip();
-					if (ins->peek() != '}')
-						while (ok) {
-							// first validate and get the property name string
-							skip();
-							ok &= ins->peek() == '"';
-							if (!ok) break; // stop if not a string property
-											// now reset the tmp string
-							tmp.clear();
-							// read in the property name
-							visit(tmp);
-							// ensure that we have a correct separator :
-							skip();
-							ok &= ins->get() == ':';
-							if (!ok) break; // stop if syntax error
-							skip();
-							// invoke the consumer function with the key to parse the rest
-							g(tmp);
-							tmp.clear();
-							skip();
-							if (ins->peek() == '}')
-								break; // end of object
-							ok &= ins->get() == ',';
-							skip();
+				return out;
+			}
+
+			// classify 64 bytes (all must be readable)
+			inline block classify(const char *p) {
+#if defined(__AVX2__)
+				block out;
+				out.space = out.op = out.quote = out.backslash = 0;
+				for (int i = 0;i < 64;i += 32) {
+					__m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+					// or:ing in 0x20 folds [ and ] onto { and }
+					__m256i lc = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+					__m256i op = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(lc, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lc, _mm256_set1_epi8('}'))),
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+					__m256i space = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+					out.op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+					out.space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << i;
+					out.quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << i;
+					out.backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << i;
+				}
+				return out;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+				block out;
+				out.space = out.op = out.quote = out.backslash = 0;
+				for (int i = 0;i < 64;i += 16) {
+					__m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+					// or:ing in 0x20 folds [ and ] onto { and }
+					__m128i lc = _mm_or_si128(v, _mm_set1_epi8(0x20));
+					__m128i op = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(lc, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lc, _mm_set1_epi8('}'))),
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+					__m128i space = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+					out.op |= (uint64_t)_mm_movemask_epi8(op) << i;
+					out.space |= (uint64_t)_mm_movemask_epi8(space) << i;
+					out.quote |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << i;
+					out.backslash |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << i;
+				}
+				return out;
+#else
+				return classify_scalar(p);
+#endif
+			}
+
+			// length of the leading run of string characters that can be copied verbatim, the run
+			// ends at a quote, backslash, control character or non-ASCII byte.
+			inline size_t plain_run(const char *p, size_t n) {
+				size_t i = 0;
+#if defined(__AVX2__)
+				for (;i + 32 <= n;i += 32) {
+					__m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+					// as signed bytes both control characters and non-ASCII bytes are below 0x20
+					__m256i stop = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+						_mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+					uint32_t mask = (uint32_t)_mm256_movemask_epi8(stop);
+					if (mask)
+						return i + trailing_zeroes(mask);
+				}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+				for (;i + 16 <= n;i += 16) {
+					__m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+					// as signed bytes both control characters and non-ASCII bytes are below 0x20
+					__m128i stop = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+						_mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+					uint32_t mask = (uint32_t)_mm_movemask_epi8(stop);
+					if (mask)
+						return i + trailing_zeroes(mask);
+				}
+#endif
+				for (;i < n;i++) {
+					unsigned char c = (unsigned char)p[i];
+					if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80)
+						break;
+				}
+				return i;
+			}
+
+			// reads an integer without a fraction or exponent and at most 18 digits (so that it can't
+			// overflow), returns its length or 0 if the number at p is anything else or reaches the
+			// end of the n bytes.
+			inline size_t plain_integer(const char *p, size_t n, bool &negative, uint64_t &value) {
+				size_t i = 0;
+				negative = n && *p == '-';
+				if (negative)
+					i++;
+				size_t start = i;
+				uint64_t v = 0;
+				while (i < n && is_digit(p[i]) && i - start < 19)
+					v = v * 10 + (p[i++] - '0');
+				size_t digits = i - start;
+				if (!digits || digits > 18 || i >= n || (digits > 1 && p[start] == '0'))
+					return 0;
+				char c = p[i];
+				if (c == '.' || c == 'e' || c == 'E' || is_digit(c))
+					return 0;
+				value = v;
+				return i;
+			}
+
+			// moves i past the end quote of the string whose body starts at p[i], returns false if the
+			// string doesn't end within the n bytes.
+			inline bool skip_string(const char *p, size_t n, size_t &i) {
+				while (i < n) {
+					if (n - i >= 64) {
+						block b = classify(p + i);
+						uint64_t stops = b.quote | b.backslash;
+						if (!stops) {
+							i += 64;
+							continue;
 						}
-					if (ok)
-						ins->get(); // read '}'
-					return true;
+						i += trailing_zeroes(stops);
+					}
+					char c = p[i++];
+					if (c == '"')
+						return true;
+					if (c == '\\')
+						i++;
 				}
-				virtual bool consume_array(const std::function<void()> &g) {
-					// JSON array
-					ok &= ins->get() == '[';
-					if (!ok) return true;
-					tmp.clear();
-					if (ins->peek() != ']')
-						while (ok) {
-							skip();
-							// just let the consumer read in the members
-							g();
-							skip();
-							// and detect the trailing ']' or check the separator comma
-							if (ins->peek() == ']')
+				return false;
+			}
+
+			// is there only space between the separator at i of the array at p and the previous one
+			// (or the opening bracket)? The character before a separator can only be a comma if
+			// it's the previous separator since nested values end with a bracket.
+			inline bool empty_element(const char *p, size_t i) {
+				while (is_space(p[--i])) {}
+				return i == 0 || p[i] == ',';
+			}
+
+			// counts the elements of the array starting with the bracket at p by counting the commas
+			// outside of strings and nested values, returns 0 if it doesn't end within the n bytes or
+			// has empty elements. length is set to the length of the array including the brackets.
+			inline size_t count_elements(const char *p, size_t n, size_t &length) {
+				size_t commas = 0;
+				size_t i = 1;
+				int depth = 1;
+				// an empty array has no elements despite having no commas
+				while (i < n && is_space(p[i]))
+					i++;
+				if (i < n && p[i] == ']') {
+					length = i + 1;
+					return 0;
+				}
+				while (i < n) {
+					if (n - i >= 64) {
+						block b = classify(p + i);
+						uint64_t stops = b.op | b.quote;
+						if (!b.backslash) {
+							// strings without escapes are masked out, see json_parser::skip_balanced
+							uint64_t inside = prefix_xor(b.quote);
+							stops = b.op & ~inside;
+							if (inside >> 63) {
+								uint64_t open = 1ULL << (63 - leading_zeroes(b.quote));
+								stops = (stops & (open - 1)) | open;
+							}
+						}
+						for (;stops;stops &= stops - 1) {
+							int idx = trailing_zeroes(stops);
+							char c = p[i + idx];
+							if (c == '"') {
+								i += idx;
 								break;
-							ok &= ins->get() == ',';
-							skip();
+							} else if (c == '{' || c == '[') {
+								depth++;
+							} else if (c == '}' || c == ']') {
+								if (!--depth) {
+									length = i + idx + 1;
+									return empty_element(p, i + idx) ? 0 : commas + 1;
+								}
+							} else if (c == ',' && depth == 1) {
+								if (empty_element(p, i + idx))
+									return 0;
+								commas++;
+							}
 						}
-					if (ok)
-						ins->get(); // get end ']'
-					return true;
-				}
-				// boolean parsing
-				virtual void visit(bool &bv) {
-					skip();
-					if (ins->peek() == 't') {
-						bv = true;
-						match("true");
-					} else {
-						bv = false;
-						match("false");
+						if (!stops) {
+							i += 64;
+							continue;
+						}
+					}
+					char c = p[i++];
+					if (c == '"') {
+						if (!skip_string(p, n, i))
+							return 0;
+					} else if (c == '{' || c == '[') {
+						depth++;
+					} else if (c == '}' || c == ']') {
+						if (!--depth) {
+							length = i;
+							return empty_element(p, i - 1) ? 0 : commas + 1;
+						}
+					} else if (c == ',' && depth == 1) {
+						if (empty_element(p, i - 1))
+							return 0;
+						commas++;
 					}
 				}
-				// a dual purpose function to parse JSON numbers
-				// and convert them to a double of the current locale since the
-				// standard built in double parsing functions are locale dependant
-				void consume_frac_and_exp() {
-					// if we have a decimal point consume it.
-					if (ins->peek() == '.') {
-						// eat the dot
-						ins->get();
-						// but append the locale decimal point
-						tmp.append(localeconv()->decimal_point);
-						while (std::isdigit(ins->peek()))
-							tmp.push_back(ins->get());
+				return 0;
+			}
+			inline size_t count_elements(const char *p, size_t n) {
+				size_t length;
+				return count_elements(p, n, length);
+			}
+
+			// validates the UTF-8 sequence starting with the non-ASCII byte at p, overlong forms,
+			// surrogates and codepoints above 0x10ffff are rejected. Returns the length of the
+			// sequence, 0 if it's invalid or -1 if it continues beyond the n available bytes.
+			inline int utf8_sequence(const unsigned char *p, size_t n) {
+				unsigned c = p[0];
+				int len;
+				unsigned lo = 0x80, hi = 0xbf; // valid range of the second byte
+				if (c < 0xc2) {
+					return 0; // continuation byte or an overlong 2 byte form
+				} else if (c < 0xe0) {
+					len = 2;
+				} else if (c < 0xf0) {
+					len = 3;
+					if (c == 0xe0)
+						lo = 0xa0;
+					else if (c == 0xed)
+						hi = 0x9f;
+				} else if (c < 0xf5) {
+					len = 4;
+					if (c == 0xf0)
+						lo = 0x90;
+					else if (c == 0xf4)
+						hi = 0x8f;
+				} else {
+					return 0;
+				}
+				if (n < 2)
+					return -1;
+				if (p[1] < lo || p[1] > hi)
+					return 0;
+				for (int i = 2;i < len;i++) {
+					if ((size_t)i >= n)
+						return -1;
+					if ((p[i] & 0xc0) != 0x80)
+						return 0;
+				}
+				return len;
+			}
+
+			// length of the leading part of a string body that can be used verbatim, that is plain
+			// characters and valid UTF8 sequences up to the first quote, escape or invalid byte.
+			inline size_t verbatim_run(const char *p, size_t n) {
+				size_t run = 0;
+				while (run < n) {
+					run += plain_run(p + run, n - run);
+					if (run == n || !((unsigned char)p[run] & 0x80))
+						break;
+					int len = utf8_sequence((const unsigned char*)p + run, n - run);
+					if (len <= 0)
+						break;
+					run += len;
+				}
+				return run;
+			}
+		}
+
+		// Input sources for the json_parser below, a source only needs to
+		// provide peek and get (returning EOF at the end of input), skip_space
+		// as well as tell/seek so that the parser can go back to a previous position.
+		// Sources that hold their input in memory can also expose the buffered
+		// data through buffered/advance for bulk processing, persistent tells if
+		// that data stays valid after the parse so that parsed values can refer to it.
+
+		// source reading characters from a std::istream
+		class stream_source {
+			std::istream *in;
+			// position of the next character
+			size_t pos = 0;
+			// characters consumed after tell() are recorded so that seek() can go back by
+			// replaying them, this works on streams that can't seek (pipes, sockets, etc).
+			bool recording = false;
+			std::string record;
+			size_t record_pos = 0;
+			// characters to read before continuing with the stream.
+			std::string replay;
+			size_t replay_off = 0;
+		public:
+			stream_source(std::istream &in) : in(&in) {}
+			int peek() {
+				if (replay_off < replay.size())
+					return replay[replay_off] & 0xff;
+				return in->peek();
+			}
+			int get() {
+				int c = replay_off < replay.size() ? replay[replay_off++] & 0xff : in->get();
+				if (c != EOF) {
+					pos++;
+					if (recording)
+						record.push_back((char)c);
+				}
+				return c;
+			}
+			void skip_space() {
+				while (is_space(peek()))
+					get();
+			}
+			size_t tell() {
+				if (!recording) {
+					recording = true;
+					record.clear();
+					record_pos = pos;
+				}
+				return pos;
+			}
+			// go back to a position returned from tell()
+			void seek(size_t to) {
+				record.erase(0, to - record_pos);
+				record.append(replay, replay_off, std::string::npos);
+				replay.swap(record);
+				replay_off = 0;
+				recording = false;
+				pos = to;
+			}
+			// the stream buffer isn't accessible so everything goes through peek/get
+			const char* buffered(size_t &avail) {
+				avail = 0;
+				return nullptr;
+			}
+			void advance(size_t /*count*/) {}
+			bool persistent() {
+				return false;
+			}
+		};
+
+		// source reading characters from a contiguous memory buffer with plain pointer
+		// arithmetic, the buffer must stay alive while the parser is running.
+		class buffer_source {
+			const char *cur;
+			const char *end;
+			bool m_persistent;
+		public:
+			// persistent buffers are owned by the caller and can be referenced by string_ref's
+			buffer_source(const char *data, size_t size, bool persistent = true) : cur(data), end(data + size), m_persistent(persistent) {}
+			int peek() {
+				return cur != end ? (*cur) & 0xff : EOF;
+			}
+			int get() {
+				return cur != end ? (*cur++) & 0xff : EOF;
+			}
+			void skip_space() {
+				if (cur == end || !is_space(*cur))
+					return;
+				// single spaces between tokens are the common case so only
+				// longer runs (indentation) are scanned a block at a time.
+				if (++cur == end || !is_space(*cur))
+					return;
+				while (end - cur >= 64) {
+					uint64_t nonspace = ~scan::classify(cur).space;
+					if (nonspace) {
+						cur += scan::trailing_zeroes(nonspace);
+						return;
 					}
-					// do we have an exponent?
-					if (ins->peek() == 'e' || ins->peek() == 'E') {
-						tmp.push_back(ins->get());
-						if (ins->peek() == '+' || ins->peek() == '-') {
-							tmp.push_back(ins->get());
+					cur += 64;
+				}
+				while (cur != end && is_space(*cur))
+					cur++;
+			}
+			const char* tell() {
+				return cur;
+			}
+			void seek(const char *pos) {
+				cur = pos;
+			}
+			// the remaining input, advance consumes count characters of it.
+			const char* buffered(size_t &avail) {
+				avail = end - cur;
+				return cur;
+			}
+			void advance(size_t count) {
+				cur += count;
+			}
+			bool persistent() {
+				return m_persistent;
+			}
+		};
+
+		// the JSON parser, implemented as a rpoco visitor that consumes
+		// input from the source type S.
+		template<typename S>
+		struct json_parser : public rpoco::visitor {
+			// validity indicator, used for early exiting after errors
+			bool ok = true;
+			// the input source
+			S src;
+			// temporary string object used during various phases of the parsing
+			std::string tmp;
+			// allow C/C++ style comments within JSON literals
+			bool allow_c_comments;
+			// decode utf16 surrogates
+			bool utf16_to_utf8;
+			// current member we're working with.
+			rpoco::member * current_member = 0;
+			// leave objects and arrays read into json::value's unparsed until they're accessed
+			bool lazy = false;
+			// where pointer targets and json::value data is placed, nullptr for the global heap
+			rpoco::memory_resource *memory = nullptr;
+			// overwrite vectors in place instead of appending to them
+			bool reuse = false;
+			// the brackets open while skipping a value, kept to reuse its storage
+			std::string skip_stack;
+
+			// constructor to take the options and input for the parser.
+			json_parser(const S &src, bool allow_c_comments = false, bool utf16_to_utf8 = true) : src(src) {
+				this->allow_c_comments = allow_c_comments;
+				this->utf16_to_utf8 = utf16_to_utf8;
+			}
+			virtual void error(const std::string &/*err*/) {
+				ok = false;
+			}
+			virtual rpoco::memory_resource* resource() {
+				return memory;
+			}
+			virtual bool reusing() {
+				return reuse;
+			}
+			// arrays are counted ahead when they're already buffered in full, comments could hide
+			// commas so they aren't counted when comments are allowed. The hint never reserves more
+			// than 8 times the bytes of the array so that malformed input can't amplify memory use.
+			virtual size_t size_hint(size_t element_size) {
+				if (allow_c_comments || peek() != rpoco::vt_array)
+					return 0;
+				size_t avail, length = 0;
+				const char *p = src.buffered(avail);
+				size_t count = p ? scan::count_elements(p, avail, length) : 0;
+				size_t most = length * 8 / (element_size ? element_size : 1);
+				return count < most ? count : most;
+			}
+
+			// skip non-spaces (and comments if that is enabled)
+			void skip() {
+				while (ok) {
+					src.skip_space();
+					if (allow_c_comments && src.peek() == '/') {
+						src.get(); // eat '/'
+						switch (src.peek()) { // what kind of comment do we have
+						case '/':
+							// single line comment, eat until carriage return,linefeed or form feed
+							while (true) {
+								int c = src.peek();
+								if (c == 13 || c == 10 || c == 12 || c == EOF) {
+									break;
+								} else {
+									src.get();
+									continue;
+								}
+							}
+							continue;
+						case '*':
+							// multiline comment
+						{
+							src.get(); // eat '*'
+							int last = 0;
+							while (ok) {
+								int c = src.get();
+								if (c == EOF) {
+									// EOF inside comment leads to a syntax error.
+									ok = false;
+									break;
+								} else if (last == '*'&&c == '/') {
+									// end of multiline comment found.
+									break;
+								} else {
+									last = c;
+								}
+							}
+							if (ok)
+								continue;
+							break;
 						}
-						if (!std::isdigit(ins->peek()))
+						default:
+							// syntax error in JSON
 							ok = false;
-						while (std::isdigit(ins->peek()))
-							tmp.push_back(ins->get());
+							break;
+						}
 					}
+					// not a comment
+					break;
 				}
-				virtual void visit(float &fv) {
-					// let the double visitor do the parsing then downconvert to a float
-					double tmp;
-					visit(tmp);
-					if (ok)
-						fv = (float)tmp;
+			}
+			// production functions are invalid to be called by the visitor during parsing.
+			virtual void produce_start(rpoco::visit_type /*vt*/) {
+				abort(); // should not be called
+			}
+			// production functions are invalid to be called by the visitor during parsing.
+			virtual void produce_end(rpoco::visit_type /*vt*/) {
+				abort(); // should not be called
+			}
+			// the peek function hints at what kind of objects can be consumed.
+			virtual rpoco::visit_type peek() {
+				skip(); // skip any spaces and comments so we can identify the token based on the first character
+				// first check digits
+				if (is_digit(src.peek()))
+					return rpoco::vt_number;
+				switch (src.peek()) {
+				case '{': // object start
+					return rpoco::vt_object;
+				case '[': // array start
+					return rpoco::vt_array;
+				case '\"': // string start
+					return rpoco::vt_string;
+				case 't': // true start
+				case 'f': // false start
+					return rpoco::vt_bool;
+				case 'n': // null start
+					return rpoco::vt_null;
+				case '-': // negative number start
+					return rpoco::vt_number;
+				default: // invalid object start, stop parsing.
+					ok = false;
+					return rpoco::vt_error;
 				}
-				// double number visitor
-				virtual void visit(double &dv) {
+			}
+			// a match function used to skip the remainder of known constants (null/true/false)
+			void match(const char *s) {
+				for (int i = 0;s[i];i++)
+					ok &= (src.get() == s[i]);
+			}
+			// null parsing
+			virtual void visit_null() {
+				skip();
+				match("null");
+			}
+			// skips over a value without storing it, the value is validated like the regular parse
+			// would with a stack of the open brackets instead of recursion.
+			void skip_value() {
+				std::string &open = skip_stack;
+				open.clear();
+				while (ok) {
 					skip();
-					tmp.clear();
-					// consume negative sign
-					if (ins->peek() == '-') {
-						tmp.push_back(ins->get());
+					int c = src.peek();
+					switch (c) {
+					case '{':
+					case '[':
+						src.get();
+						skip();
+						if (src.peek() == (c == '{' ? '}' : ']')) {
+							src.get();
+							break;
+						}
+						open.push_back((char)c);
+						if (c == '{')
+							skip_key();
+						continue;
+					case '"':
+						src.get();
+						skip_string_body();
+						break;
+					case 't':
+						match("true");
+						break;
+					case 'f':
+						match("false");
+						break;
+					case 'n':
+						match("null");
+						break;
+					default: {
+						number n;
+						ok &= scan_number(n);
 					}
-					// consume either a solitary 0 or a sequence of digits
-					if (ins->peek() == '0') {
-						tmp.push_back(ins->get());
-					} else if (std::isdigit(ins->peek())) {
-						while (std::isdigit(ins->peek()))
-							tmp.push_back(ins->get());
-					} else {
-						ok = false;
+					}
+					// a value has ended, close the containers ending with it and go on with the next member or element
+					while (ok && !open.empty()) {
+						skip();
+						c = src.get();
+						if (c == ',') {
+							if (open.back() == '{')
+								skip_key();
+							break;
+						}
+						ok &= c == (open.back() == '{' ? '}' : ']');
+						open.pop_back();
+					}
+					if (open.empty())
+						return;
+				}
+			}
+			// skips a member name and the colon after it
+			void skip_key() {
+				skip();
+				ok &= src.get() == '"';
+				if (!ok)
+					return;
+				skip_string_body();
+				skip();
+				ok &= src.get() == ':';
+			}
+			// unknown fields are skipped without parsing them, invalid starts are still caught by peek.
+			virtual bool skip_unknown() {
+				if (peek() != rpoco::vt_error)
+					skip_value();
+				return true;
+			}
+			// skips the rest of a string validating it like readStringBody
+			void skip_string_body() {
+				while (ok) {
+					size_t avail;
+					if (const char *p = src.buffered(avail))
+						src.advance(scan::verbatim_run(p, avail));
+					int c = src.peek();
+					if (c == '"') {
+						src.get();
 						return;
 					}
-					consume_frac_and_exp();
-					if (ok)
-						dv = std::stod(tmp);
-					tmp.clear();
-				}
-				// integer visitor, has a fast path for obvious integers and also
-				// a checking path that parses the number as a double and then
-				// checks that the result is still an integer (or fails the parsing)
-				virtual void visit(int &iv) {
-					skip();
-					int sign = 1;
-					int acc = 0;
-					if (ins->peek() == '-') {
-						ins->get();
-						sign = -1;
+					if (c == EOF || c < 32) {
+						ok = false;
+					} else if (c == '\\') {
+						readEscape();
+					} else if (c & 0x80) {
+						std::string seq;
+						readSequence(seq);
+					} else {
+						src.get();
 					}
-					while (std::isdigit(ins->peek())) {
-						acc = acc * 10 + (ins->get() - '0');
+				}
+			}
+			// passes over a value tracking only brackets and strings, so it's only loosely validated
+			// and meant for finding where values end that are parsed properly afterwards.
+			void skip_balanced() {
+				skip();
+				int c = src.peek();
+				if (c == '{' || c == '[') {
+					int depth = 0;
+					while (ok) {
+						// without comments only brackets and quotes matter so whole blocks are
+						// classified at once and everything else is passed over.
+						size_t avail;
+						const char *p = src.buffered(avail);
+						if (!allow_c_comments && avail >= 64) {
+							scan::block b = scan::classify(p);
+							uint64_t stops = b.op | b.quote;
+							if (!b.backslash) {
+								// without escapes the quotes pair up so the strings can be masked out,
+								// only a string running past the block is left to skip_string_loose.
+								uint64_t inside = scan::prefix_xor(b.quote);
+								stops = b.op & ~inside;
+								if (inside >> 63) {
+									uint64_t open = 1ULL << (63 - scan::leading_zeroes(b.quote));
+									stops = (stops & (open - 1)) | open;
+								}
+							}
+							for (;stops;stops &= stops - 1) {
+								int idx = scan::trailing_zeroes(stops);
+								c = p[idx];
+								if (c == '"') {
+									// strings are left to skip_string_loose below
+									src.advance(idx);
+									break;
+								} else if (c == '{' || c == '[') {
+									depth++;
+								} else if ((c == '}' || c == ']') && !--depth) {
+									src.advance(idx + 1);
+									return;
+								}
+							}
+							if (!stops) {
+								src.advance(64);
+								continue;
+							}
+						}
+						skip();
+						c = src.get();
+						if (c == '"') {
+							skip_string_loose();
+						} else if (c == '{' || c == '[') {
+							depth++;
+						} else if (c == '}' || c == ']') {
+							if (!--depth)
+								return;
+						} else if (c == EOF) {
+							ok = false;
+						}
 					}
-					iv = sign*acc;
-					// now a fallback in case we got something more complex than a simple integer.
-					int c = ins->peek();
-					if (c == '.' || c == 'e' || c == 'E') {
-						// not encoded as a just a simple integer, do a complex fallback path.
-						// first dump the integer prefix
-						tmp = std::to_string(acc);
-						// then consume the rest of the number info
-						consume_frac_and_exp();
-						if (ok) {
-							double dv = std::stod(tmp);
-							iv = (int)dv;
-							// verify that the number was a valid integer.
-							ok = ((double)iv == dv);
+				} else if (c == '"') {
+					src.get();
+					skip_string_loose();
+				} else {
+					// numbers and constants
+					while ((c = src.peek()) != EOF && c != ',' && c != '}' && c != ']' && c != '/' && !is_space(c))
+						src.get();
+				}
+			}
+			// passes over the rest of a string without validating its contents
+			void skip_string_loose() {
+				while (ok) {
+					// blocks without quotes or escapes are passed over at once
+					size_t avail;
+					const char *p = src.buffered(avail);
+					if (avail >= 64) {
+						scan::block b = scan::classify(p);
+						uint64_t stops = b.quote | b.backslash;
+						if (!stops) {
+							src.advance(64);
+							continue;
 						}
-						tmp.clear();
+						src.advance(scan::trailing_zeroes(stops));
 					}
+					int c = src.get();
+					if (c == '"')
+						return;
+					if (c == '\\')
+						c = src.get();
+					if (c == EOF)
+						ok = false;
 				}
-				// reads a single UTF16 character inside a string, used by
-				// the string parsing to convert the result to a
-				// UTF8 representation without codepoints.
-				int readSimpleCharacter() {
-					int c = read_utf8(*ins);
-					if (c == '\\') {
-						switch (c = ins->get()) {
-						case '\"': case '\\': case '/':
-							break; // use the character found directly.
-						case 'b':
-							c = '\b';
-							break;
-						case 'f':
-							c = '\f';
+			}
+			// hands over the upcoming object or array unparsed for lazy values, the text is only
+			// referred to so this is limited to sources that stay around. It's validated while it's
+			// skipped so parsing it later can't fail.
+			virtual bool capture(rpoco::string_ref &raw, unsigned &options) {
+				if (!lazy || !src.persistent())
+					return false;
+				options = (allow_c_comments ? value::lazy_comments : 0) | (utf16_to_utf8 ? value::lazy_utf16_to_utf8 : 0);
+				skip();
+				size_t before, after;
+				const char *text = src.buffered(before);
+				skip_value();
+				src.buffered(after);
+				raw.refer(text, before - after);
+				return ok;
+			}
+			// looks ahead for the string value of a key in the upcoming object, the values before it are
+			// skipped and the source is rewound afterwards so the object can be parsed directly into
+			// the type the value selects.
+			bool scan_selector(const std::string &key, std::string &value) {
+				auto pos = src.tell();
+				bool found = false;
+				std::string name;
+				skip();
+				if (src.get() == '{') {
+					while (ok) {
+						skip();
+						if (src.peek() != '"')
 							break;
-						case 'n':
-							c = '\n';
+						name.clear();
+						visit(name);
+						skip();
+						if (src.get() != ':')
 							break;
-						case 'r':
-							c = '\r';
+						skip();
+						if (name == key) {
+							if (src.peek() == '"') {
+								visit(value);
+								found = ok;
+							}
 							break;
-						case 't':
-							c = '\t';
+						}
+						skip_value();
+						skip();
+						if (src.get() != ',')
 							break;
-						case 'u': {
-							c = 0;
-							for (int i = 0;i < 4;i++) {
-								int tmp = ins->get();
-								c = c << 4;
-								if ('0' <= tmp && tmp <= '9')
-									c |= tmp - '0';
-								else if ('A' <= tmp && tmp <= 'F')
-									c |= tmp - 'A' + 10;
-								else if ('a' <= tmp && tmp <= 'f')
-									c |= tmp - 'a' + 10;
-								else {
-									ok = false;
-									return EOF;
+					}
+				}
+				src.seek(pos);
+				return found;
+			}
+			// the select_info of the current member if the object ahead has a selector value
+			select_info* selection(std::string &selector) {
+				if (!current_member)
+					return nullptr;
+				select_info * info=current_member->attribute<rpoco::json::select_info>();
+				return info && scan_selector(info->key(), selector) ? info : nullptr;
+			}
+			virtual void* construct(std::type_index /*index*/, rpoco::visit_fn &visit_as) {
+				visit_as = nullptr;
+				std::string selector;
+				select_info *info = selection(selector);
+				return info ? info->construct(selector, visit_as) : nullptr;
+			}
+			virtual const std::type_info* selected(std::type_index /*index*/, rpoco::visit_fn &visit_as) {
+				visit_as = nullptr;
+				std::string selector;
+				select_info *info = selection(selector);
+				return info ? info->type(selector, visit_as) : nullptr;
+			}
+			// variant alternatives of objects are picked by the selector value if the member has a select_info
+			virtual int choose(const std::type_index *types, const rpoco::visit_type *kinds, int count) {
+				if (peek() == vt_object && current_member) {
+					if (select_info * info = current_member->attribute<rpoco::json::select_info>()) {
+						std::string selector;
+						const std::type_info *type = scan_selector(info->key(), selector) ? info->type(selector) : nullptr;
+						for (int i = 0;type && i < count;i++)
+							if (types[i] == std::type_index(*type))
+								return i;
+						return -1;
+					}
+				}
+				return rpoco::visitor::choose(types, kinds, count);
+			}
+			// object,map and array parsing functions ("consumption")
+			virtual bool consume_object(member_provider &mp,void *obj) {
+				// check if we have a json_typeinfo mapping that overrides the regular object layout.
+				json_typeinfo *jti = mp.attribute<json_typeinfo>();
+				// the next member in declaration order is tried first
+				int hint = 0;
+				// reused objects have the members that the input leaves out reset afterwards, the
+				// members that are set are marked by position (the hint is the position after a match).
+				int count = reuse ? (jti ? jti->size() : mp.size()) : 0;
+				uint64_t set = 0;
+				std::vector<bool> set_many; // for types with more than 64 members
+				if (count > 64)
+					set_many.assign(count, false);
+				if (reuse && jti)
+					jti->reset_extra(obj);
+				consume_members([&](const char *key, size_t len) {
+					// members are looked up directly on the raw key
+					rpoco::member *member = jti ? jti->find(key, len, hint) : mp.find(key, len, hint);
+					if (member) {
+						if (count > 64)
+							set_many[hint - 1] = true;
+						else if (count)
+							set |= (uint64_t)1 << (hint - 1);
+						auto old_member = current_member;
+						current_member = member;
+						if (jti)
+							jti->visit(member, *this, obj);
+						else
+							member->visit(*this, obj);
+						current_member = old_member;
+					} else if (!jti || !jti->consume_extra(*this, obj, std::string(key, len))) {
+						visit_nil(*this);
+					}
+				});
+				for (int i = 0;ok && i < count;i++) {
+					if (count > 64 ? !set_many[i] : !(set >> i & 1))
+						(jti ? jti->at(i) : mp[i])->reset(obj);
+				}
+				return true;
+			}
+			virtual bool consume_map(const std::function<void(const std::string&)> &g) {
+				consume_members([&](const char *key, size_t len) {
+					if (key != tmp.data())
+						tmp.assign(key, len);
+					g(tmp);
+				});
+				return true;
+			}
+			// parses a JSON object, g is called with the key of each member to parse the value. Keys
+			// without escapes are passed straight from persistent sources, others are read to tmp.
+			template<typename G>
+			void consume_members(const G &g) {
+				ok &= src.get() == '{';
+				if (!ok) return;
+				skip();
+				if (src.peek() != '}')
+					while (ok) {
+						// first validate and get the property name string
+						skip();
+						ok &= src.peek() == '"';
+						if (!ok) break; // stop if not a string property
+						const char *key = nullptr;
+						size_t len = 0;
+						size_t avail;
+						if (const char *p = src.buffered(avail)) {
+							len = scan::verbatim_run(p + 1, avail - 1);
+							if (len + 1 < avail && p[len + 1] == '"') {
+								key = p + 1;
+								if (!src.persistent()) {
+									// the buffer might be gone once the value is reached
+									tmp.assign(key, len);
+									key = tmp.data();
 								}
+								src.advance(len + 2);
 							}
-						} break;
-						default:
-							ok = false;
-							return EOF;
 						}
+						if (!key) {
+							// read in the property name
+							tmp.clear();
+							visit(tmp);
+							key = tmp.data();
+							len = tmp.size();
+						}
+						// ensure that we have a correct separator :
+						skip();
+						ok &= src.get() == ':';
+						if (!ok) break; // stop if syntax error
+						skip();
+						// invoke the consumer function with the key to parse the rest
+						g(key, len);
+						skip();
+						if (src.peek() == '}')
+							break; // end of object
+						ok &= src.get() == ',';
+						skip();
+					}
+				if (ok)
+					src.get(); // read '}'
+			}
+			virtual bool consume_array(const std::function<void()> &g) {
+				// JSON array
+				ok &= src.get() == '[';
+				if (!ok) return true;
+				tmp.clear();
+				if (src.peek() != ']')
+					while (ok) {
+						skip();
+						// just let the consumer read in the members
+						g();
+						skip();
+						// and detect the trailing ']' or check the separator comma
+						if (src.peek() == ']')
+							break;
+						ok &= src.get() == ',';
+						skip();
 					}
-					return c;
+				if (ok)
+					src.get(); // get end ']'
+				return true;
+			}
+			// boolean parsing
+			virtual void visit(bool &bv) {
+				skip();
+				if (src.peek() == 't') {
+					bv = true;
+					match("true");
+				} else {
+					bv = false;
+					match("false");
 				}
-				// Parse strings to UTF8, converts UTF16 surrogate pairs
-				// to full codepoints if the option is enabled.
-				virtual void visit(std::string &str) {
-					skip();
-					ok &= ins->get() == '"';
-					if (!ok) return;
+			}
+			// scans a JSON number while validating the syntax, the number is converted by the
+			// caller so that no precision is lost on the way to the target type.
+			bool scan_number(number &n) {
+				skip();
+				int c = src.peek();
+				if (c == '-') {
+					n.negative = true;
+					n.append(src.get());
+					c = src.peek();
+				}
+				// either a solitary 0 or a sequence of digits
+				if (c == '0') {
+					n.append(src.get());
+				} else if (is_digit(c)) {
+					do {
+						n.add_digit(src.get(), false);
+					} while (is_digit(src.peek()));
+				} else {
+					return false;
+				}
+				if (src.peek() == '.') {
+					n.integer = false;
+					n.append(src.get());
+					if (!is_digit(src.peek()))
+						return false;
+					do {
+						n.add_digit(src.get(), true);
+					} while (is_digit(src.peek()));
+				}
+				c = src.peek();
+				if (c == 'e' || c == 'E') {
+					n.integer = false;
+					n.append(src.get());
+					bool negative = false;
+					c = src.peek();
+					if (c == '+' || c == '-') {
+						negative = c == '-';
+						n.append(src.get());
+					}
+					if (!is_digit(src.peek()))
+						return false;
+					int exp = 0;
+					do {
+						c = src.get();
+						n.append(c);
+						if (exp < 100000) // anything larger is out of range anyhow
+							exp = exp * 10 + (c - '0');
+					} while (is_digit(src.peek()));
+					n.exponent += negative ? -exp : exp;
+				}
+				return true;
+			}
+			virtual void visit(float &fv) {
+				number n;
+				if (!scan_number(n)) {
+					ok = false;
+					return;
+				}
+				// converted directly instead of via a double to avoid double rounding
+				fv = n.to_float();
+			}
+			// double number visitor
+			virtual void visit(double &dv) {
+				number n;
+				if (!scan_number(n)) {
+					ok = false;
+					return;
+				}
+				dv = n.to_double();
+			}
+			// the numbers of bulk arrays are read straight from the buffered input when possible
+			bool read_number(number &n) {
+				size_t avail, len;
+				const char *p = src.buffered(avail);
+				if (p && n.parse(p, avail, len)) {
+					src.advance(len);
+					return true;
+				}
+				n = number();
+				return scan_number(n);
+			}
+			static bool convert(const number &n, float &v) {
+				v = n.to_float();
+				return true;
+			}
+			static bool convert(const number &n, double &v) {
+				v = n.to_double();
+				return true;
+			}
+			template<typename I>
+			static bool convert(const number &n, I &v) {
+				return n.to_integer(v);
+			}
+			// plain integers that are exact in the target type are converted without a number
+			static bool convert(bool negative, uint64_t m, float &v) {
+				if (m > (1 << 24))
+					return false;
+				v = negative ? -(float)m : (float)m;
+				return true;
+			}
+			static bool convert(bool negative, uint64_t m, double &v) {
+				if (m > (1ULL << 53))
+					return false;
+				v = negative ? -(double)m : (double)m;
+				return true;
+			}
+			template<typename I>
+			static bool convert(bool negative, uint64_t m, I &v) {
+				if (negative && m) {
+					if (!std::numeric_limits<I>::is_signed || m - 1 > (uint64_t)std::numeric_limits<I>::max())
+						return false;
+					v = (I)(-(I)(m - 1) - 1);
+				} else {
+					if (m > (uint64_t)std::numeric_limits<I>::max())
+						return false;
+					v = (I)m;
+				}
+				return true;
+			}
+			// arrays of numbers are read in one loop without a callback and visit per element
+			template<typename N>
+			bool consume_number_array(std::vector<N> &out) {
+				skip();
+				if (src.peek() != '[')
+					return false; // left to the regular path
+				src.get();
+				skip();
+				if (src.peek() != ']') {
 					while (ok) {
-						int c = ins->peek();
-						if (c == EOF || c < 32) {
-							// EOF or control code encountered
-							ok = false;
-							return;
+						size_t avail;
+						const char *p = src.buffered(avail);
+						bool negative;
+						uint64_t m;
+						size_t len = p ? scan::plain_integer(p, avail, negative, m) : 0;
+						N v;
+						if (len && convert(negative, m, v)) {
+							src.advance(len);
+						} else {
+							number n;
+							if (!read_number(n) || !convert(n, v)) {
+								ok = false;
+								return true;
+							}
 						}
-						if (c == '"')
-							break;
-						c = readSimpleCharacter();
-						if (c == EOF) {
-							ok = false;
-							break;
+						out.push_back(v);
+						// the separator usually follows right away
+						p = src.buffered(avail);
+						if (avail > 1 && *p == ',' && !is_space(p[1]) && p[1] != '/') {
+							src.advance(1);
+							continue;
 						}
-						if (utf16_to_utf8 && c >= 0xd800 && c < 0xdc00) {
-							// surrogate pair encountered and conversion enabled.
-							int c2 = readSimpleCharacter();
-							if (!(c2 >= 0xdc00 && c2 < 0xe000)) {
-								// invalid secondary surrogate pair character
+						skip();
+						if (src.peek() == ']')
+							break;
+						ok &= src.get() == ',';
+						skip();
+					}
+				}
+				if (ok)
+					src.get(); // get end ']'
+				return true;
+			}
+			virtual bool consume_numbers(std::vector<int> &out) {
+				return consume_number_array(out);
+			}
+			virtual bool consume_numbers(std::vector<int64_t> &out) {
+				return consume_number_array(out);
+			}
+			virtual bool consume_numbers(std::vector<uint64_t> &out) {
+				return consume_number_array(out);
+			}
+			virtual bool consume_numbers(std::vector<float> &out) {
+				return consume_number_array(out);
+			}
+			virtual bool consume_numbers(std::vector<double> &out) {
+				return consume_number_array(out);
+			}
+			// integer visitors, the digits are accumulated with an overflow check during the scan
+			// and the conversion fails for numbers with a fraction or outside of the target range.
+			template<typename I>
+			void visit_integer(I &iv) {
+				number n;
+				if (!scan_number(n) || !n.to_integer(iv))
+					ok = false;
+			}
+			virtual void visit(int &iv) {
+				visit_integer(iv);
+			}
+			virtual void visit(int64_t &iv) {
+				visit_integer(iv);
+			}
+			virtual void visit(uint64_t &iv) {
+				visit_integer(iv);
+			}
+			// integers without a fraction or exponent are kept exact when they fit in 64 bits
+			virtual void visit(rpoco::any_number &x) {
+				number n;
+				if (!scan_number(n)) {
+					ok = false;
+					return;
+				}
+				if (n.integer && n.to_integer(x.i))
+					x.kind = rpoco::any_number::signed_integer;
+				else if (n.integer && n.to_integer(x.u))
+					x.kind = rpoco::any_number::unsigned_integer;
+				else {
+					x.kind = rpoco::any_number::real;
+					x.d = n.to_double();
+				}
+			}
+			// reads a single UTF16 character inside a string, used by
+			// the string parsing to convert the result to a
+			// UTF8 representation without codepoints.
+			int readSimpleCharacter() {
+				int c = read_utf8(src);
+				if (c == '\\') {
+					switch (c = src.get()) {
+					case '\"': case '\\': case '/':
+						break; // use the character found directly.
+					case 'b':
+						c = '\b';
+						break;
+					case 'f':
+						c = '\f';
+						break;
+					case 'n':
+						c = '\n';
+						break;
+					case 'r':
+						c = '\r';
+						break;
+					case 't':
+						c = '\t';
+						break;
+					case 'u': {
+						c = 0;
+						for (int i = 0;i < 4;i++) {
+							int tmp = src.get();
+							c = c << 4;
+							if ('0' <= tmp && tmp <= '9')
+								c |= tmp - '0';
+							else if ('A' <= tmp && tmp <= 'F')
+								c |= tmp - 'A' + 10;
+							else if ('a' <= tmp && tmp <= 'f')
+								c |= tmp - 'a' + 10;
+							else {
 								ok = false;
-								return;
+								return EOF;
 							}
-							c = (((c & 0x3ff) << 10) | (c2 & 0x3ff)) + 0x10000;
 						}
-						dump_utf8(str, c);
+					} break;
+					default:
+						ok = false;
+						return EOF;
+					}
+				}
+				return c;
+			}
+			// reads an escape, surrogate pairs are combined into their codepoint if that is enabled.
+			// Returns EOF for invalid escapes.
+			int readEscape() {
+				int c = readSimpleCharacter();
+				if (c == EOF) {
+					ok = false;
+					return EOF;
+				}
+				if (utf16_to_utf8 && c >= 0xd800 && c < 0xdc00) {
+					// surrogate pair encountered and conversion enabled, the second half must also be escaped.
+					int c2 = src.peek() == '\\' ? readSimpleCharacter() : EOF;
+					if (!(c2 >= 0xdc00 && c2 < 0xe000)) {
+						// invalid secondary surrogate pair character
+						ok = false;
+						return EOF;
 					}
-					// eat "
-					ins->get();
+					c = (((c & 0x3ff) << 10) | (c2 & 0x3ff)) + 0x10000;
+				} else if (utf16_to_utf8 && c >= 0xdc00 && c < 0xe000) {
+					// a second half without a first one has no codepoint
+					ok = false;
+					return EOF;
+				}
+				return c;
+			}
+			// reads a non-ASCII UTF8 sequence (when it didn't fit the buffered data) and validates it.
+			void readSequence(std::string &str) {
+				unsigned char seq[4];
+				seq[0] = (unsigned char)src.get();
+				int len = scan::utf8_sequence(seq, 1);
+				for (int i = 1;len < 0 && i < 4;i++) {
+					int c = src.get();
+					if (c == EOF)
+						break;
+					seq[i] = (unsigned char)c;
+					len = scan::utf8_sequence(seq, i + 1);
 				}
-				// fixed size string
-				virtual void visit(char *str, size_t sz) {
+				if (len <= 0) {
+					ok = false;
+					return;
+				}
+				str.append((const char*)seq, len);
+			}
+			// Parse strings to UTF8, converts UTF16 surrogate pairs
+			// to full codepoints if the option is enabled.
+			virtual void visit(std::string &str) {
+				skip();
+				ok &= src.get() == '"';
+				if (!ok) return;
+				readStringBody(str);
+			}
+			// strings are referenced in place when the source is persistent and the string has no escapes
+			virtual void visit(string_ref &sr) {
+				skip();
+				size_t avail;
+				const char *p = src.buffered(avail);
+				if (!p || !src.persistent()) {
 					std::string tmp;
 					visit(tmp);
-					if (tmp.size() >= sz) {
+					sr.assign(std::move(tmp));
+					return;
+				}
+				ok &= avail && *p == '"';
+				if (!ok) return;
+				size_t run = scan::verbatim_run(p + 1, avail - 1);
+				src.advance(run + 1);
+				if (src.peek() == '"') {
+					src.get();
+					sr.refer(p + 1, run);
+				} else {
+					// escapes need decoding to a copy
+					std::string tmp(p + 1, run);
+					readStringBody(tmp);
+					sr.assign(std::move(tmp));
+				}
+			}
+			// parses the rest of a string after the opening quote
+			void readStringBody(std::string &str) {
+				while (ok) {
+					// runs of plain characters and valid UTF8 sequences are copied in bulk when the
+					// source has the data buffered, the rest is handled character by character below.
+					size_t avail;
+					if (const char *p = src.buffered(avail)) {
+						size_t run = scan::verbatim_run(p, avail);
+						str.append(p, run);
+						src.advance(run);
+					}
+					int c = src.peek();
+					if (c == EOF || c < 32) {
+						// EOF or control code encountered
 						ok = false;
-						str[0] = 0;
-					} else {
-						memcpy(str, tmp.data(), sz);
-						str[sz] = 0;
+						return;
+					}
+					if (c == '"')
+						break;
+					if (c & 0x80) {
+						readSequence(str);
+						continue;
+					}
+					if (c != '\\') {
+						str.push_back((char)src.get());
+						continue;
 					}
+					c = readEscape();
+					if (c == EOF)
+						break;
+					dump_utf8(str, c);
 				}
-			};
+				// eat "
+				src.get();
+			}
+			// fixed size string
+			virtual void visit(char *str, size_t sz) {
+				std::string tmp;
+				visit(tmp);
+				if (tmp.size() >= sz) {
+					ok = false;
+					str[0] = 0;
+				} else {
+					memcpy(str, tmp.data(), tmp.size());
+					str[tmp.size()] = 0;
+				}
+			}
+		};
+
+		// internal parsing function shared by the public parse functions
+		// X is the type of the RPOCO conforming target data type that will receive the root JSON data object.
+		template<typename S, typename X> bool parse_source(const S &src, X &x, bool allow_c_comments, bool utf16_to_utf8, rpoco::memory_resource *memory = nullptr, bool reuse = false) {
 			// init parser object and then use it to visit the target
-			json_parser parser(in, allow_c_comments, utf16_to_utf8);
+			json_parser<S> parser(src, allow_c_comments, utf16_to_utf8);
+			parser.memory = memory;
+			parser.reuse = reuse;
 			parser.skip(); // pre-skip any spaces,etc at the start of the text
 			rpoco::visit<X>(parser, x);
 			parser.skip(); // post skip to get to the end of the file so we can report a completed parse
-			return parser.ok && EOF == in.peek();
+			return parser.ok && EOF == parser.src.peek();
+		}
+
+		// the public JSON parsing functions
+		// X is the type of the RPOCO conforming target data type that will receive the root JSON data object.
+		// utf16 to utf8 translates utf16 surrogate pairs to utf8 codepoints
+		template<typename X> bool parse(std::istream &in, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_source(stream_source(in), x, allow_c_comments, utf16_to_utf8);
 		}
-		// small utility to wrap strings into streams if needed for parsing.
-		template<typename X> bool parse(std::string &string, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
-			std::istringstream stream(string);
-			return parse(stream, x, allow_c_comments, utf16_to_utf8);
+		// parse directly from a memory buffer without going through a stream.
+		template<typename X> bool parse(const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_source(buffer_source(data, size), x, allow_c_comments, utf16_to_utf8);
+		}
+		template<typename X> bool parse(const std::string &string, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse(string.data(), string.size(), x, allow_c_comments, utf16_to_utf8);
+		}
+#if __cplusplus >= 201703L || _MSVC_LANG >= 201703L
+		template<typename X> bool parse(std::string_view string, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse(string.data(), string.size(), x, allow_c_comments, utf16_to_utf8);
+		}
+#endif
+		// parse with json::value strings, arrays and objects placed in a memory resource (f.ex. an
+		// rpoco::arena that is reset once a request is done). Pointer targets are still allocated
+		// with new since their owners release them with delete.
+		template<typename X> bool parse(rpoco::memory_resource &memory, const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_source(buffer_source(data, size), x, allow_c_comments, utf16_to_utf8, &memory);
+		}
+		template<typename X> bool parse(rpoco::memory_resource &memory, const std::string &string, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse(memory, string.data(), string.size(), x, allow_c_comments, utf16_to_utf8);
 		}
 
-		// function to dump an arbitrary RPOCO oobject as a string containing a JSON object
-		template<typename X> std::string to_json(X &x) {
-			// the json_writer extends the rpoco::visitor struct to receive
-			// data as the generic visitation code visits the structure.
-			struct json_writer : public rpoco::visitor {
-				// the output string
-				std::string out;
-				// state stack to keep track of terminators at each level.
-				enum wrstate {
-					def = 0x1, // default
-					objid = 0x2, // inside object expecting a propname
-					objval = 0x3, // inside object expecting a value
-					objnxt = 0x4, // inside object either expecting term or a new propname
-					ary = 0x5, // inside array
-					arynxt = 0x6, // inside array either expecting term or a new value
-					end = 0x1000 // termination
-				};
-				std::vector<wrstate> state;
-				// initialize state with a dummy constructor
-				json_writer() {
-					state = { def };
-				}
-				// pre-value function call to dump the appropriate separator
-				// characters when the value is a member of a object literal or array
-				void pre(bool str) {
-					if (state.back() == end) {
-						// cannot write objects if we're at an end-state
-						abort();
-					}
-					if (state.back() == objnxt) {
-						// with another property being added to an object,
-						// add a ',' and advance state
-						out.append(",");
-						state.back() = objid;
-					}
-					if (state.back() == objid && !str) {
-						// object property names must be strings
-						abort();
-					} else if (state.back() == arynxt) {
-						// append commas when expecting another value in
-						// an array
-						out.append(",");
+		// parses into an object that is reused between parses, vectors are overwritten element by
+		// element instead of appended to and strings are assigned so that the elements, strings
+		// and pointer targets already there keep their allocations. The result is what a regular
+		// parse into a fresh object gives: fields missing from the input are reset (strings and
+		// vectors are cleared, keeping their capacity), pointer targets given null are released
+		// and select() targets of another type are replaced. Ignored fields keep their values.
+		template<typename X> bool parse_reuse(const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_source(buffer_source(data, size), x, allow_c_comments, utf16_to_utf8, nullptr, true);
+		}
+		template<typename X> bool parse_reuse(const std::string &string, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_reuse(string.data(), string.size(), x, allow_c_comments, utf16_to_utf8);
+		}
+		template<typename X> bool parse_reuse(std::istream &in, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_source(stream_source(in), x, allow_c_comments, utf16_to_utf8, nullptr, true);
+		}
+
+		// parses with the objects and arrays that end up in json::value's left unparsed until they're
+		// accessed so only the parts actually read are parsed. The buffer must outlive the values,
+		// unparsed parts are still validated (without building anything) so errors anywhere fail
+		// the parse.
+		template<typename X> bool parse_lazy(const char *data, size_t size, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			json_parser<buffer_source> parser(buffer_source(data, size), allow_c_comments, utf16_to_utf8);
+			parser.lazy = true;
+			parser.skip();
+			rpoco::visit<X>(parser, x);
+			parser.skip();
+			return parser.ok && EOF == parser.src.peek();
+		}
+		template<typename X> bool parse_lazy(const std::string &string, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_lazy(string.data(), string.size(), x, allow_c_comments, utf16_to_utf8);
+		}
+
+		// lazy values are parsed with the options their text was validated with.
+		inline void value::materialize() {
+			const char *text = data.raw.text;
+			size_t size = data.raw.size;
+			unsigned options = m_small;
+			rpoco::visit_type type = (rpoco::visit_type)m_type;
+			set_type(type);
+			json_parser<buffer_source> parser(buffer_source(text, size), (options & lazy_comments) != 0, (options & lazy_utf16_to_utf8) != 0);
+			// the members and elements are in turn left unparsed
+			parser.lazy = true;
+			if (type == rpoco::vt_object)
+				consume_members(parser);
+			else
+				consume_elements(parser);
+			parser.skip();
+			// the text was validated up front so this is only a safeguard
+			if (!parser.ok || EOF != parser.src.peek())
+				set_null();
+		}
+		inline bool value::set_lazy(rpoco::visit_type toType, const char *text, size_t size, bool allow_c_comments, bool utf16_to_utf8) {
+			json_parser<buffer_source> parser(buffer_source(text, size), allow_c_comments, utf16_to_utf8);
+			bool valid = (toType == rpoco::vt_object || toType == rpoco::vt_array) && parser.peek() == toType;
+			// only the value itself is kept, without the spaces and comments around it
+			size_t before = 0, after = 0;
+			if (valid) {
+				text = parser.src.buffered(before);
+				parser.skip_value();
+				parser.src.buffered(after);
+				parser.skip();
+				valid = parser.ok && EOF == parser.src.peek();
+			}
+			if (!valid) {
+				set_null();
+				return false;
+			}
+			refer_lazy(toType, text, before - after, (allow_c_comments ? lazy_comments : 0) | (utf16_to_utf8 ? lazy_utf16_to_utf8 : 0));
+			return true;
+		}
+
+		// read only view of the contents of a whole file, regular files are memory mapped
+		// while inputs that can't be mapped (pipes, devices, etc) are read into memory instead.
+		class mapped_file {
+			const char *m_data = nullptr;
+			size_t m_size = 0;
+			bool m_ok = false;
+			bool m_mapped = false;
+			// only used if the file was read instead of mapped
+			std::string m_read;
+#ifdef _WIN32
+			HANDLE m_mapping = NULL;
+#endif
+			mapped_file(const mapped_file&) = delete;
+			mapped_file& operator=(const mapped_file&) = delete;
+		public:
+			mapped_file(const std::string &path) {
+#ifdef _WIN32
+				HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+				if (file == INVALID_HANDLE_VALUE)
+					return;
+				LARGE_INTEGER size;
+				if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &size) && size.QuadPart > 0 && (unsigned long long)size.QuadPart <= (size_t)-1) {
+					m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+					if (m_mapping) {
+						m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+						if (m_data) {
+							m_size = (size_t)size.QuadPart;
+							m_mapped = true;
+						} else {
+							CloseHandle(m_mapping);
+							m_mapping = NULL;
+						}
 					}
 				}
-				// post-value, update state
-				void post() {
-					switch (state.back()) {
-					case ary:
-						state.back() = arynxt;
-						break;
-					case objid:
-						out.append(":");
-						state.back() = objval;
-						break;
-					case objval:
-						state.back() = objnxt;
-						break;
-					case def:
-						state.back() = end;
-						break;
-					}
+				if (!m_mapped) {
+					// fall back to reading the data
+					char buf[65536];
+					DWORD count;
+					while (ReadFile(file, buf, sizeof(buf), &count, NULL) && count)
+						m_read.append(buf, count);
+					m_data = m_read.data();
+					m_size = m_read.size();
 				}
-				virtual void produce_object(member_provider &mp, void *obj) {
-					if (auto jti = mp.attribute<json_typeinfo>()) {
-						jti->produce_object(*this, obj);
-					} else {
-						rpoco::visitor::produce_object(mp, obj);
+				CloseHandle(file);
+				m_ok = true;
+#else
+				int fd = ::open(path.c_str(), O_RDONLY);
+				if (fd < 0)
+					return;
+				struct stat st;
+				if (0 == fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0 && (unsigned long long)st.st_size <= (size_t)-1) {
+					void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (p != MAP_FAILED) {
+						m_data = (const char*)p;
+						m_size = (size_t)st.st_size;
+						m_mapped = true;
+#ifdef MADV_SEQUENTIAL
+						madvise(p, m_size, MADV_SEQUENTIAL);
+#endif
 					}
 				}
-				// called when entering a object or array
-				// responsible for updating the state stack
-				virtual void produce_start(rpoco::visit_type vt) {
-					switch (vt) {
-					case rpoco::vt_object:
-						// update the previous level
-						pre(false);
-						// print and setup the object
-						out.append("{");
-						state.push_back(objid);
-						break;
-					case rpoco::vt_array:
-						// update the previous level
-						pre(false);
-						// print and setup the array
-						out.append("[");
-						state.push_back(ary);
-						break;
-					default:
-						abort();
+				if (!m_mapped) {
+					// fall back to reading the data (pipes or files where the size isn't known)
+					char buf[65536];
+					while (true) {
+						ssize_t count = ::read(fd, buf, sizeof(buf));
+						if (count < 0 && errno == EINTR)
+							continue;
+						if (count <= 0) {
+							if (count < 0) {
+								::close(fd);
+								return;
+							}
+							break;
+						}
+						m_read.append(buf, (size_t)count);
 					}
+					m_data = m_read.data();
+					m_size = m_read.size();
 				}
-				// visitor interface to query production or consumption mode
-				virtual bool consume_object(member_provider &mp,void *p) {
-					return false;
+				::close(fd);
+				m_ok = true;
+#endif
+			}
+			~mapped_file() {
+				if (!m_mapped)
+					return;
+#ifdef _WIN32
+				UnmapViewOfFile(m_data);
+				CloseHandle(m_mapping);
+#else
+				munmap((void*)m_data, m_size);
+#endif
+			}
+			// was the file opened properly?
+			bool ok() {
+				return m_ok;
+			}
+			const char* data() {
+				return m_data;
+			}
+			size_t size() {
+				return m_size;
+			}
+		};
+
+		// parse a whole file in place (no stream buffering or extra copies for regular files)
+		template<typename X> bool parse_file(const std::string &path, X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			mapped_file file(path);
+			if (!file.ok())
+				return false;
+			// the mapping goes away on return so string_ref's can't refer to it
+			return parse_source(buffer_source(file.data(), file.size(), false), x, allow_c_comments, utf16_to_utf8);
+		}
+
+		// formats an integer backwards from the end of a buffer (of at least 20 chars) two
+		// digits at a time, returns the start of the digits.
+		inline char* format_integer(char *end, uint64_t v, bool negative) {
+			static const char pairs[] =
+				"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+				"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+				"8081828384858687888990919293949596979899";
+			char *p = end;
+			while (v >= 100) {
+				const char *pair = pairs + (v % 100) * 2;
+				v /= 100;
+				*--p = pair[1];
+				*--p = pair[0];
+			}
+			if (v >= 10) {
+				*--p = pairs[v * 2 + 1];
+				*--p = pairs[v * 2];
+			} else {
+				*--p = (char)('0' + v);
+			}
+			if (negative)
+				*--p = '-';
+			return p;
+		}
+
+		// the json_writer extends the rpoco::visitor struct to receive
+		// data as the generic visitation code visits the structure.
+		struct json_writer : public rpoco::visitor {
+			// the output string, with a sink it's handed over and cleared whenever a value ends
+			// past the flush size so that it stays bounded.
+			std::string out;
+			std::function<bool(const char*, size_t)> sink;
+			size_t flush_size = 0;
+			// set once the sink has refused output, the rest is dropped
+			bool failed = false;
+			// state stack to keep track of terminators at each level.
+			enum wrstate {
+				def = 0x1, // default
+				objid = 0x2, // inside object expecting a propname
+				objval = 0x3, // inside object expecting a value
+				objnxt = 0x4, // inside object either expecting term or a new propname
+				ary = 0x5, // inside array
+				arynxt = 0x6, // inside array either expecting term or a new value
+				end = 0x1000 // termination
+			};
+			std::vector<wrstate> state;
+			// initialize state with a dummy constructor
+			json_writer() {
+				state = { def };
+			}
+			json_writer(const std::function<bool(const char*, size_t)> &sink, size_t flush_size) : sink(sink), flush_size(flush_size) {
+				state = { def };
+				out.reserve(flush_size);
+			}
+			void flush() {
+				if (!failed && !out.empty() && !sink(out.data(), out.size()))
+					failed = true;
+				out.clear();
+			}
+			// once the sink has failed the rest of the data isn't visited
+			virtual bool stopped() {
+				return failed;
+			}
+			// pre-value function call to dump the appropriate separator
+			// characters when the value is a member of a object literal or array
+			void pre(bool str) {
+				if (state.back() == end) {
+					// cannot write objects if we're at an end-state
+					abort();
 				}
-				virtual bool consume_map(const std::function<void(const std::string&)> &out) {
-					return false;
+				if (state.back() == objnxt) {
+					// with another property being added to an object,
+					// add a ',' and advance state
+					out.append(",");
+					state.back() = objid;
 				}
-				virtual bool consume_array(const std::function<void()> &out) {
-					return false;
+				if (state.back() == objid && !str) {
+					// object property names must be strings
+					abort();
+				} else if (state.back() == arynxt) {
+					// append commas when expecting another value in
+					// an array
+					out.append(",");
 				}
-				// called to produce the object end
-				virtual void produce_end(rpoco::visit_type vt) {
-					switch (vt) {
-					case rpoco::vt_object:
-						// sanity check
-						if (state.back() != objid && state.back() != objnxt)
-							abort();
-						// exit object
-						state.pop_back();
-						out.append("}");
-						// call parent state to indicate end-of-value
-						post();
-						break;
-					case rpoco::vt_array:
-						// sanity check
-						if (state.back() != ary && state.back() != arynxt)
-							abort();
-						// exit array
-						state.pop_back();
-						out.append("]");
-						// call parent state to indicate end-of-value
-						post();
-						break;
-					default:
-						abort();
-					}
+			}
+			// post-value, update state
+			void post() {
+				switch (state.back()) {
+				case ary:
+					state.back() = arynxt;
+					break;
+				case objid:
+					out.append(":");
+					state.back() = objval;
+					break;
+				case objval:
+					state.back() = objnxt;
+					break;
+				case def:
+					state.back() = end;
+					break;
 				}
-				// boolean visitor
-				virtual void visit(bool& bv) {
-					// sanity check
-					if (state.back() == objid)
-						abort();
-					// inform parent of value start
-					pre(false);
-					// dump value
-					out.append(bv ? "true" : "false");
-					// inform parent of value end
-					post();
+				if (sink && out.size() >= flush_size)
+					flush();
+			}
+			virtual void produce_object(member_provider &mp, void *obj) {
+				if (auto jti = mp.attribute<json_typeinfo>()) {
+					jti->produce_object(*this, obj);
+				} else {
+					rpoco::visitor::produce_object(mp, obj);
 				}
-				virtual void visit(float &fv) {
-					double tmp = fv;
-					visit(tmp);
+			}
+			// called when entering a object or array
+			// responsible for updating the state stack
+			virtual void produce_start(rpoco::visit_type vt) {
+				// nothing more is written after a failure but the state is kept for produce_end
+				if (failed)
+					out.clear();
+				switch (vt) {
+				case rpoco::vt_object:
+					// update the previous level
+					pre(false);
+					// print and setup the object
+					out.append("{");
+					state.push_back(objid);
+					break;
+				case rpoco::vt_array:
+					// update the previous level
+					pre(false);
+					// print and setup the array
+					out.append("[");
+					state.push_back(ary);
+					break;
+				default:
+					abort();
 				}
-				// double visitor
-				virtual void visit(double& dv) {
+			}
+			// visitor interface to query production or consumption mode
+			virtual bool consume_object(member_provider &/*mp*/,void * /*p*/) {
+				return false;
+			}
+			virtual bool consume_map(const std::function<void(const std::string&)> &/*out*/) {
+				return false;
+			}
+			virtual bool consume_array(const std::function<void()> &/*out*/) {
+				return false;
+			}
+			// called to produce the object end
+			virtual void produce_end(rpoco::visit_type vt) {
+				switch (vt) {
+				case rpoco::vt_object:
 					// sanity check
-					if (state.back() == objid)
+					if (state.back() != objid && state.back() != objnxt)
 						abort();
-					// inform parent of value start
-					pre(false);
-					// dump double string
-					char buf[500];
-#ifdef _MSC_VER
-					sprintf_s(buf, sizeof(buf), "%.17g", dv);
-#else
-					snprintf(buf, sizeof(buf), "%.17g", dv);
-#endif
-					// replace commas in locales where
-					// they appear.
-					for (int i = 0;buf[i];i++)
-						if (buf[i] == ',')
-							buf[i] = '.';
-					out.append(buf);
-					// inform parent of value end
+					// exit object
+					state.pop_back();
+					out.append("}");
+					// call parent state to indicate end-of-value
 					post();
-				}
-				// integer visitor
-				virtual void visit(int& iv) {
+					break;
+				case rpoco::vt_array:
 					// sanity check
-					if (state.back() == objid)
+					if (state.back() != ary && state.back() != arynxt)
 						abort();
-					// inform parent of value start
-					pre(false);
-					// dump integer string
-					out.append(std::to_string(iv));
-					// inform parent of value end
-					post();
-				}
-				// get 1 hex character
-				char toHex(int c) {
-					c &= 0xf;
-					if (c < 10)
-						return c + '0';
-					else
-						return c - 10 + 'A';
-				}
-				// dump JSON UTF16 codepoint
-				void dumpUniEscape(int c) {
-					out.append("\\u");
-					out.push_back(toHex(c >> 12));
-					out.push_back(toHex(c >> 8));
-					out.push_back(toHex(c >> 4));
-					out.push_back(toHex(c));
-				}
-				// visit null terminated string
-				virtual void visit(char *str, size_t sz) {
-					// TODO: encapsulate to avoid copy and construction
-					for (size_t i = 0;i < sz;i++)
-						if (!str[i])
-							sz = i;
-					std::string tmp(str, sz);
-					visit(tmp);
-				}
-				virtual void visit(std::string &str) {
-					struct strsrc {
-						std::string *p;
-						int idx;
-						strsrc(std::string *s) {
-							idx = 0;
-							p = s;
-						}
-						int peek() {
-							if (idx == p->size())
-								return EOF;
-							return ((*p)[idx]) & 0xff;
-						}
-						int get() {
-							int c = peek();
-							if (c != EOF) idx++;
-							return c;
-						}
-					}src(&str);
-					pre(true);
-					out.append("\"");
-					// TODO: proper string encoding
-					//out.append(str);
-					while (src.peek() != EOF) {
-						int c = read_utf8(src);
-						//printf("Encoding:%d (%c)\n",c,c);
-						switch (c) {
-						case '\"':
-							out.append("\\\"");
-							continue;
-						case '\\':
-							out.append("\\\\");
-							continue;
-							//case '/' :
-							//	out.append("\\/");
-							//	continue;
-						case '\b':
-							out.append("\\b");
-							continue;
-						case '\f':
-							out.append("\\f");
-							continue;
-						case '\n':
-							out.append("\\n");
-							continue;
-						case '\r':
-							out.append("\\r");
-							continue;
-						case '\t':
-							out.append("\\t");
-							continue;
-						}
-						if (c >= 32 && c < 127) {
-							out.push_back((char)c);
-						} else if (c > 0x10ffff) {
-							abort(); // out of range character
-						} else if (c > 0xffff) {
-							c -= 0x10000;
-							dumpUniEscape(0xd800 | ((c >> 10) & 0x3ff));
-							dumpUniEscape(0xdc00 | (c & 0x3ff));
-						} else {
-							dumpUniEscape(c);
-						}
-					}
-					out.append("\"");
+					// exit array
+					state.pop_back();
+					out.append("]");
+					// call parent state to indicate end-of-value
 					post();
+					break;
+				default:
+					abort();
 				}
-				virtual rpoco::visit_type peek() {
-					return rpoco::vt_none;
-				}
-				virtual void visit_null() {
-					pre(false);
-					out.append("null");
+			}
+			// boolean visitor
+			virtual void visit(bool& bv) {
+				// sanity check
+				if (state.back() == objid)
+					abort();
+				// inform parent of value start
+				pre(false);
+				// dump value
+				out.append(bv ? "true" : "false");
+				// inform parent of value end
+				post();
+			}
+			virtual void visit(float &fv) {
+				double tmp = fv;
+				visit(tmp);
+			}
+			// double visitor
+			virtual void visit(double& dv) {
+				// sanity check
+				if (state.back() == objid)
+					abort();
+				// inform parent of value start
+				pre(false);
+				char buf[500];
+				// integral values are common and formatted much quicker as integers, the
+				// range is kept well below 17 digits so the output is the same as %.17g
+				if (dv > -1e15 && dv < 1e15 && dv == (double)(int64_t)dv && (dv != 0 || 1 / dv > 0)) {
+					write_integer(dv < 0 ? (uint64_t)-(int64_t)dv : (uint64_t)dv, dv < 0);
 					post();
+					return;
 				}
-				virtual void error(const std::string &err) {
+				// dump double string
+#ifdef _MSC_VER
+				sprintf_s(buf, sizeof(buf), "%.17g", dv);
+#else
+				snprintf(buf, sizeof(buf), "%.17g", dv);
+#endif
+				// replace commas in locales where
+				// they appear.
+				for (int i = 0;buf[i];i++)
+					if (buf[i] == ',')
+						buf[i] = '.';
+				out.append(buf);
+				// inform parent of value end
+				post();
+			}
+			// dump an integer without a temporary string
+			void write_integer(uint64_t magnitude, bool negative) {
+				char buf[24];
+				char *end = buf + sizeof(buf);
+				char *start = format_integer(end, magnitude, negative);
+				out.append(start, end - start);
+			}
+			// integer visitors
+			void visit_integer(uint64_t magnitude, bool negative) {
+				// sanity check
+				if (state.back() == objid)
 					abort();
+				// inform parent of value start
+				pre(false);
+				// dump integer string
+				write_integer(magnitude, negative);
+				// inform parent of value end
+				post();
+			}
+			virtual void visit(int& iv) {
+				visit_integer(iv < 0 ? 0 - (uint64_t)iv : (uint64_t)iv, iv < 0);
+			}
+			virtual void visit(int64_t& iv) {
+				visit_integer(iv < 0 ? 0 - (uint64_t)iv : (uint64_t)iv, iv < 0);
+			}
+			virtual void visit(uint64_t& iv) {
+				visit_integer(iv, false);
+			}
+			// get 1 hex character
+			char toHex(int c) {
+				c &= 0xf;
+				if (c < 10)
+					return c + '0';
+				else
+					return c - 10 + 'A';
+			}
+			// dump JSON UTF16 codepoint
+			void dumpUniEscape(int c) {
+				out.append("\\u");
+				out.push_back(toHex(c >> 12));
+				out.push_back(toHex(c >> 8));
+				out.push_back(toHex(c >> 4));
+				out.push_back(toHex(c));
+			}
+			// visit null terminated string
+			virtual void visit(char *str, size_t sz) {
+				// TODO: encapsulate to avoid copy and construction
+				for (size_t i = 0;i < sz;i++)
+					if (!str[i])
+						sz = i;
+				std::string tmp(str, sz);
+				visit(tmp);
+			}
+			virtual void visit(std::string &str) {
+				struct strsrc {
+					std::string *p;
+					int idx;
+					strsrc(std::string *s) {
+						idx = 0;
+						p = s;
+					}
+					int peek() {
+						if (idx == p->size())
+							return EOF;
+						return ((*p)[idx]) & 0xff;
+					}
+					int get() {
+						int c = peek();
+						if (c != EOF) idx++;
+						return c;
+					}
+				}src(&str);
+				pre(true);
+				out.append("\"");
+				// TODO: proper string encoding
+				//out.append(str);
+				while (src.peek() != EOF) {
+					int c = read_utf8(src);
+					//printf("Encoding:%d (%c)\n",c,c);
+					switch (c) {
+					case '\"':
+						out.append("\\\"");
+						continue;
+					case '\\':
+						out.append("\\\\");
+						continue;
+						//case '/' :
+						//	out.append("\\/");
+						//	continue;
+					case '\b':
+						out.append("\\b");
+						continue;
+					case '\f':
+						out.append("\\f");
+						continue;
+					case '\n':
+						out.append("\\n");
+						continue;
+					case '\r':
+						out.append("\\r");
+						continue;
+					case '\t':
+						out.append("\\t");
+						continue;
+					}
+					if (c >= 32 && c < 127) {
+						out.push_back((char)c);
+					} else if (c > 0x10ffff) {
+						abort(); // out of range character
+					} else if (c > 0xffff) {
+						c -= 0x10000;
+						dumpUniEscape(0xd800 | ((c >> 10) & 0x3ff));
+						dumpUniEscape(0xdc00 | (c & 0x3ff));
+					} else {
+						dumpUniEscape(c);
+					}
 				}
-			};
+				out.append("\"");
+				post();
+			}
+			virtual rpoco::visit_type peek() {
+				return rpoco::vt_none;
+			}
+			virtual void visit_null() {
+				pre(false);
+				out.append("null");
+				post();
+			}
+			virtual void error(const std::string &/*err*/) {
+				abort();
+			}
+		};
+
+		// function to dump an arbitrary RPOCO oobject as a string containing a JSON object
+		template<typename X> std::string to_json(X &x) {
 			json_writer writer;
 
 			rpoco::visit<X>(writer, x);
 			return writer.out;
 		}
 
+		// Writes an RPOCO object as JSON to a sink as it's produced instead of building the whole
+		// document first, sink(data, size) gets the output in pieces of about buffer_size bytes (a
+		// single long string can exceed it) and returns false to stop. Returns false if it did.
+		template<typename X> bool write(const std::function<bool(const char*, size_t)> &sink, X &x, size_t buffer_size = 64 * 1024) {
+			json_writer writer(sink, buffer_size);
+			rpoco::visit<X>(writer, x);
+			writer.flush();
+			return !writer.failed;
+		}
+		template<typename X> bool write(std::ostream &os, X &x, size_t buffer_size = 64 * 1024) {
+			return write([&os](const char *data, size_t size) {
+				return !!os.write(data, (std::streamsize)size);
+			}, x, buffer_size) && os.flush();
+		}
+#ifndef _WIN32
+		// writes to a file descriptor, f.ex. a socket or a pipe.
+		template<typename X> bool write(int fd, X &x, size_t buffer_size = 64 * 1024) {
+			return write([fd](const char *data, size_t size) {
+				while (size) {
+					ssize_t n = ::write(fd, data, size);
+					if (n < 0 && errno == EINTR)
+						continue;
+					if (n <= 0)
+						return false;
+					data += n;
+					size -= (size_t)n;
+				}
+				return true;
+			}, x, buffer_size);
+		}
+#endif
+
 
 	} // end of namespace rpoco::json
 
@@ -1313,13 +3819,48 @@ namespace rpoco {
 	template<typename X> bool parse_json(std::istream &in, X &x, bool allow_c_comments, bool utf16_to_utf8) {
 		return rpoco::json::parse(in, x, allow_c_comments, utf16_to_utf8);
 	}
-	template<typename X> bool parse_json(std::string &str, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+	template<typename X> bool parse_json(const std::string &str, X &x, bool allow_c_comments, bool utf16_to_utf8) {
 		return rpoco::json::parse(str, x, allow_c_comments, utf16_to_utf8);
 	}
+	template<typename X> bool parse_json(const char *data, size_t size, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse(data, size, x, allow_c_comments, utf16_to_utf8);
+	}
+	template<typename X> bool parse_json_file(const std::string &path, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse_file(path, x, allow_c_comments, utf16_to_utf8);
+	}
+	template<typename X> bool parse_json_lazy(const char *data, size_t size, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse_lazy(data, size, x, allow_c_comments, utf16_to_utf8);
+	}
+	template<typename X> bool parse_json(memory_resource &memory, const std::string &str, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse(memory, str, x, allow_c_comments, utf16_to_utf8);
+	}
+	template<typename X> bool parse_json(memory_resource &memory, const char *data, size_t size, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse(memory, data, size, x, allow_c_comments, utf16_to_utf8);
+	}
+	template<typename X> bool parse_json_reuse(std::istream &in, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse_reuse(in, x, allow_c_comments, utf16_to_utf8);
+	}
+	template<typename X> bool parse_json_reuse(const std::string &str, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse_reuse(str, x, allow_c_comments, utf16_to_utf8);
+	}
+	template<typename X> bool parse_json_reuse(const char *data, size_t size, X &x, bool allow_c_comments, bool utf16_to_utf8) {
+		return rpoco::json::parse_reuse(data, size, x, allow_c_comments, utf16_to_utf8);
+	}
 	// A function to convert an RPOCO compatible structure to a JSON string.
 	template<typename X> std::string to_json(X &x) {
 		return rpoco::json::to_json(x);
 	}
+	template<typename X> bool write_json(std::ostream &os, X &x, size_t buffer_size) {
+		return rpoco::json::write(os, x, buffer_size);
+	}
+#ifndef _WIN32
+	template<typename X> bool write_json(int fd, X &x, size_t buffer_size) {
+		return rpoco::json::write(fd, x, buffer_size);
+	}
+#endif
+	template<typename X> bool write_json(const std::function<bool(const char*, size_t)> &sink, X &x, size_t buffer_size) {
+		return rpoco::json::write(sink, x, buffer_size);
+	}
 
 }
 
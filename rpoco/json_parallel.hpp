@@ -0,0 +1,264 @@
+// This header provides parsing of large JSON inputs on several threads on top
+// of the regular RPOCO JSON parser.
+
+// The input is split into pieces that are parsed on their own threads, every
+// thread has its own parser that is reused for all of its records so the
+// parser buffers are only allocated once per thread.
+
+// By default the threads are created for each call, which costs some tens of
+// microseconds per thread and is why pieces are at least 64KB. Programs that
+// parse many inputs can pass an executor that runs the pieces on their own
+// thread pool instead.
+
+#ifndef __INCLUDED_RPOCO_JSON_PARALLEL_HPP__
+#define __INCLUDED_RPOCO_JSON_PARALLEL_HPP__
+
+#pragma once
+
+#include <rpoco/json.hpp>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <string.h>
+
+namespace rpoco {
+	namespace json {
+		// parses one record at a time from a buffer with the same parser.
+		template<typename T>
+		class record_parser {
+			json_parser<buffer_source> parser;
+		public:
+			record_parser(bool allow_c_comments, bool utf16_to_utf8) : parser(buffer_source(nullptr, 0), allow_c_comments, utf16_to_utf8) {}
+			bool parse(const char *data, size_t size, T &t) {
+				parser.src = buffer_source(data, size);
+				parser.ok = true;
+				parser.skip();
+				rpoco::visit<T>(parser, t);
+				parser.skip();
+				return parser.ok && EOF == parser.src.peek();
+			}
+		};
+
+		// the number of threads to use for an input, small pieces aren't worth a thread.
+		inline unsigned parallel_threads(size_t size, unsigned threads) {
+			if (!threads)
+				threads = std::thread::hardware_concurrency();
+			size_t most = size / (64 * 1024) + 1;
+			if (threads > most)
+				threads = (unsigned)most;
+			return threads ? threads : 1;
+		}
+
+		// an executor calls run(i) for every i below count, concurrently if it can, and returns
+		// once all of them are done. run doesn't throw.
+		typedef std::function<void(unsigned count, const std::function<void(unsigned i)> &run)> executor;
+
+		// runs work(i) for every piece with the executor or on threads of their own (the last one
+		// on the calling thread), exceptions are passed on to the caller once all pieces are done.
+		template<typename W>
+		void run_pieces(unsigned count, const W &work, const executor &exec = nullptr) {
+			std::vector<std::exception_ptr> exceptions(count);
+			auto run = [&work, &exceptions](unsigned i) {
+				try {
+					work(i);
+				} catch (...) {
+					exceptions[i] = std::current_exception();
+				}
+			};
+			if (exec) {
+				exec(count, run);
+			} else {
+				std::vector<std::thread> threads;
+				for (unsigned i = 0;i + 1 < count;i++)
+					threads.emplace_back(run, i);
+				if (count)
+					run(count - 1);
+				for (auto &t : threads)
+					t.join();
+			}
+			for (auto &e : exceptions)
+				if (e)
+					std::rethrow_exception(e);
+		}
+
+		// a range of lines, first is the line number of the first one.
+		struct line_piece {
+			const char *begin;
+			const char *end;
+			size_t first;
+		};
+
+		// splits text into about count pieces of whole lines.
+		inline std::vector<line_piece> split_lines(const char *data, size_t size, unsigned count) {
+			std::vector<line_piece> pieces;
+			const char *end = data + size;
+			const char *begin = data;
+			size_t line = 1;
+			for (unsigned i = 1;i <= count && begin != end;i++) {
+				const char *stop = i == count ? end : data + size / count * i;
+				if (stop < begin)
+					stop = begin;
+				if (stop != end) {
+					const char *nl = (const char*)memchr(stop, '\n', end - stop);
+					stop = nl ? nl + 1 : end;
+				}
+				pieces.push_back(line_piece{ begin, stop, line });
+				for (const char *p = begin;(p = (const char*)memchr(p, '\n', stop - p));p++)
+					line++;
+				begin = stop;
+			}
+			return pieces;
+		}
+
+		// parses the non blank lines of a piece, out(line, record) gets the records that parsed.
+		template<typename T, typename O>
+		bool parse_piece(const line_piece &piece, record_parser<T> &parser, const O &out) {
+			bool ok = true;
+			size_t line = piece.first;
+			for (const char *p = piece.begin;p != piece.end;line++) {
+				const char *nl = (const char*)memchr(p, '\n', piece.end - p);
+				const char *end = nl ? nl : piece.end;
+				const char *c = p;
+				while (c != end && is_space(*c))
+					c++;
+				if (c != end) {
+					T record;
+					if (parser.parse(c, end - c, record))
+						out(line, record);
+					else
+						ok = false;
+				}
+				p = nl ? nl + 1 : piece.end;
+			}
+			return ok;
+		}
+
+		// Parses newline delimited JSON (JSON Lines) with the lines split between threads, blank lines
+		// are skipped. callback(line, record) is called from the worker threads for every line that
+		// parsed with its line number (from 1), concurrently and in no particular order. Returns
+		// false if any line failed to parse. threads defaults to the number of cores, exec runs the
+		// pieces instead of new threads when given.
+		template<typename T, typename F>
+		bool parse_lines(const char *data, size_t size, const F &callback, unsigned threads = 0, bool allow_c_comments = false, bool utf16_to_utf8 = true, const executor &exec = nullptr) {
+			std::vector<line_piece> pieces = split_lines(data, size, parallel_threads(size, threads));
+			std::vector<char> ok(pieces.size(), 0);
+			run_pieces((unsigned)pieces.size(), [&](unsigned i) {
+				record_parser<T> parser(allow_c_comments, utf16_to_utf8);
+				ok[i] = parse_piece(pieces[i], parser, [&callback](size_t line, T &record) {
+					callback(line, record);
+				});
+			}, exec);
+			return std::find(ok.begin(), ok.end(), 0) == ok.end();
+		}
+		// Parses newline delimited JSON into a vector, the records are appended in input order.
+		// Lines that fail to parse are left out and make the function return false.
+		template<typename T>
+		bool parse_lines(const char *data, size_t size, std::vector<T> &out, unsigned threads = 0, bool allow_c_comments = false, bool utf16_to_utf8 = true, const executor &exec = nullptr) {
+			std::vector<line_piece> pieces = split_lines(data, size, parallel_threads(size, threads));
+			std::vector<std::vector<T>> parsed(pieces.size());
+			std::vector<char> ok(pieces.size(), 0);
+			run_pieces((unsigned)pieces.size(), [&](unsigned i) {
+				record_parser<T> parser(allow_c_comments, utf16_to_utf8);
+				std::vector<T> &records = parsed[i];
+				ok[i] = parse_piece(pieces[i], parser, [&records](size_t /*line*/, T &record) {
+					records.push_back(std::move(record));
+				});
+			}, exec);
+			// stitch the pieces together
+			size_t total = out.size();
+			for (auto &records : parsed)
+				total += records.size();
+			out.reserve(total);
+			for (auto &records : parsed)
+				for (auto &record : records)
+					out.push_back(std::move(record));
+			return std::find(ok.begin(), ok.end(), 0) == ok.end();
+		}
+		template<typename T>
+		bool parse_lines(const std::string &text, std::vector<T> &out, unsigned threads = 0, bool allow_c_comments = false, bool utf16_to_utf8 = true, const executor &exec = nullptr) {
+			return parse_lines(text.data(), text.size(), out, threads, allow_c_comments, utf16_to_utf8, exec);
+		}
+
+		// finds the elements of a top level array with a quick pass that only matches brackets and
+		// strings, false if the text isn't an array or has empty elements.
+		inline bool split_elements(const char *data, size_t size, std::vector<const char*> &bounds, bool allow_c_comments) {
+			json_parser<buffer_source> parser(buffer_source(data, size), allow_c_comments, true);
+			parser.skip();
+			if (parser.src.get() != '[')
+				return false;
+			parser.skip();
+			if (parser.src.peek() == ']') {
+				parser.src.get();
+			} else {
+				while (parser.ok) {
+					parser.skip();
+					bounds.push_back(parser.src.tell());
+					parser.skip_balanced();
+					bounds.push_back(parser.src.tell());
+					if (bounds[bounds.size() - 2] == bounds.back())
+						return false;
+					parser.skip();
+					int c = parser.src.get();
+					if (c == ']')
+						break;
+					if (c != ',')
+						return false;
+				}
+			}
+			parser.skip();
+			return parser.ok && EOF == parser.src.peek();
+		}
+
+		// Parses a large top level JSON array of records with the elements split between threads,
+		// the elements are appended to out in order and out is left as it was if the parse fails. The element boundaries are found by a serial
+		// pass first so this pays off for arrays of objects where parsing each element is far more
+		// work than finding its end, not for arrays of plain numbers. threads defaults to the number
+		// of cores, exec runs the pieces instead of new threads when given.
+		template<typename T>
+		bool parse_array(const char *data, size_t size, std::vector<T> &out, unsigned threads = 0, bool allow_c_comments = false, bool utf16_to_utf8 = true, const executor &exec = nullptr) {
+			std::vector<const char*> bounds;
+			if (!split_elements(data, size, bounds, allow_c_comments))
+				return false;
+			size_t count = bounds.size() / 2;
+			// pieces get about the same amount of text
+			unsigned pieces = parallel_threads(size, threads);
+			if (pieces > count)
+				pieces = count ? (unsigned)count : 1;
+			std::vector<size_t> starts(pieces + 1, count);
+			for (unsigned i = 0;i < pieces;i++)
+				starts[i] = (std::lower_bound(bounds.begin(), bounds.end(), data + size / pieces * i) - bounds.begin()) / 2;
+			// the pieces are parsed into vectors of their own that only grow as elements parse so
+			// that malformed input can't allocate much more than its own size
+			std::vector<std::vector<T>> parsed(pieces);
+			std::vector<char> ok(pieces, 0);
+			run_pieces(pieces, [&](unsigned i) {
+				record_parser<T> parser(allow_c_comments, utf16_to_utf8);
+				std::vector<T> &records = parsed[i];
+				size_t elements = starts[i + 1] - starts[i];
+				size_t text = elements ? bounds[starts[i + 1] * 2 - 1] - bounds[starts[i] * 2] : 0;
+				records.reserve(std::min(elements, text * 8 / sizeof(T)));
+				bool piece_ok = true;
+				for (size_t j = starts[i];j < starts[i + 1] && piece_ok;j++) {
+					records.emplace_back();
+					piece_ok = parser.parse(bounds[j * 2], bounds[j * 2 + 1] - bounds[j * 2], records.back());
+				}
+				ok[i] = piece_ok;
+			}, exec);
+			if (std::find(ok.begin(), ok.end(), 0) != ok.end())
+				return false;
+			// stitch the pieces together
+			out.reserve(out.size() + count);
+			for (auto &records : parsed)
+				for (auto &record : records)
+					out.push_back(std::move(record));
+			return true;
+		}
+		template<typename T>
+		bool parse_array(const std::string &text, std::vector<T> &out, unsigned threads = 0, bool allow_c_comments = false, bool utf16_to_utf8 = true, const executor &exec = nullptr) {
+			return parse_array(text.data(), text.size(), out, threads, allow_c_comments, utf16_to_utf8, exec);
+		}
+	}
+}
+
+#endif // __INCLUDED_RPOCO_JSON_PARALLEL_HPP__
@@ -0,0 +1,159 @@
+// This header provides path selective parsing on top of the regular RPOCO JSON parser, only the
+// values at a set of JSON pointers (RFC 6901) are parsed and everything else is skipped over.
+
+// Paths may use * as a wildcard token matching any member or element, f.ex. /items/*/sku.
+// When one path is a prefix of another the value is handed over for the shorter one.
+
+#ifndef __INCLUDED_RPOCO_JSON_PATHS_HPP__
+#define __INCLUDED_RPOCO_JSON_PATHS_HPP__
+
+#pragma once
+
+#include <rpoco/json.hpp>
+#include <stdexcept>
+
+namespace rpoco {
+	namespace json {
+		// walks a document with a parser, handing over the values at the paths to out(path, pointer, visitor).
+		template<typename F>
+		class path_walker {
+			json_parser<buffer_source> &parser;
+			const F &out;
+			// the tokens of each path
+			std::vector<std::vector<std::string>> paths;
+			// the paths still matching at each depth, kept between siblings to avoid reallocating
+			std::vector<std::vector<size_t>> levels;
+			// the pointer of the current value
+			std::string pointer;
+
+			// state of an object or array being walked
+			struct container {
+				path_walker *w;
+				size_t depth;
+				size_t index;
+			};
+
+			static std::vector<std::string> tokenize(const std::string &path) {
+				std::vector<std::string> tokens;
+				if (path.empty())
+					return tokens;
+				if (path[0] != '/')
+					throw std::runtime_error("JSON pointer " + path + " doesn't start with /");
+				for (size_t i = 1;i <= path.size();i++) {
+					if (i == 1 || path[i - 1] == '/')
+						tokens.emplace_back();
+					if (i == path.size() || path[i] == '/')
+						continue;
+					if (path[i] == '~' && i + 1 < path.size() && (path[i + 1] == '0' || path[i + 1] == '1')) {
+						tokens.back().push_back(path[++i] == '0' ? '~' : '/');
+					} else {
+						tokens.back().push_back(path[i]);
+					}
+				}
+				return tokens;
+			}
+			void append_token(const char *key, size_t len) {
+				pointer.push_back('/');
+				for (size_t i = 0;i < len;i++) {
+					if (key[i] == '~')
+						pointer.append("~0");
+					else if (key[i] == '/')
+						pointer.append("~1");
+					else
+						pointer.push_back(key[i]);
+				}
+			}
+			// narrows the paths of a depth to those matching the token below it
+			void narrow(size_t depth, const char *key, size_t len) {
+				if (levels.size() <= depth + 1)
+					levels.resize(depth + 2);
+				std::vector<size_t> &next = levels[depth + 1];
+				next.clear();
+				for (size_t p : levels[depth]) {
+					const std::string &token = paths[p][depth];
+					if ((token.size() == len && !memcmp(token.data(), key, len)) || token == "*")
+						next.push_back(p);
+				}
+			}
+		public:
+			path_walker(json_parser<buffer_source> &parser, const std::vector<std::string> &pointers, const F &out) : parser(parser), out(out) {
+				levels.resize(1);
+				for (size_t i = 0;i < pointers.size();i++) {
+					paths.push_back(tokenize(pointers[i]));
+					levels[0].push_back(i);
+				}
+			}
+			void walk(size_t depth) {
+				std::vector<size_t> &active = levels[depth];
+				if (active.empty()) {
+					// nothing wanted below here
+					parser.skip_unknown();
+					return;
+				}
+				for (size_t p : active) {
+					if (paths[p].size() == depth) {
+						out(p, pointer, (rpoco::visitor&)parser);
+						return;
+					}
+				}
+				// the callbacks capture a single pointer so std::function doesn't allocate
+				container c = { this, depth, 0 };
+				switch (parser.peek()) {
+				case rpoco::vt_object:
+					parser.consume_members([&c](const char *key, size_t len) {
+						size_t mark = c.w->pointer.size();
+						c.w->narrow(c.depth, key, len);
+						c.w->append_token(key, len);
+						c.w->walk(c.depth + 1);
+						c.w->pointer.resize(mark);
+					});
+					break;
+				case rpoco::vt_array:
+					parser.consume_array([&c]() {
+						size_t mark = c.w->pointer.size();
+						std::string idx = std::to_string(c.index++);
+						c.w->narrow(c.depth, idx.data(), idx.size());
+						c.w->append_token(idx.data(), idx.size());
+						c.w->walk(c.depth + 1);
+						c.w->pointer.resize(mark);
+					});
+					break;
+				default:
+					parser.skip_unknown();
+				}
+			}
+		};
+
+		// Parses only the values at the given JSON pointers out of a document, everything else is
+		// skipped without being parsed. out(path, pointer, visitor) is called for every value found
+		// with the index of the matching path and the pointer of the value (with any wildcards
+		// resolved), it must consume the value from the visitor, f.ex. with rpoco::visit<T>(v, t).
+		// Returns false if the document is invalid.
+		template<typename F>
+		bool parse_paths(const char *data, size_t size, const std::vector<std::string> &paths, const F &out, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			json_parser<buffer_source> parser(buffer_source(data, size), allow_c_comments, utf16_to_utf8);
+			path_walker<F> walker(parser, paths, out);
+			parser.skip();
+			walker.walk(0);
+			parser.skip();
+			return parser.ok && EOF == parser.src.peek();
+		}
+		template<typename F>
+		bool parse_paths(const std::string &text, const std::vector<std::string> &paths, const F &out, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_paths(text.data(), text.size(), paths, out, allow_c_comments, utf16_to_utf8);
+		}
+		// Parses the values at the given JSON pointers into an object keyed by the pointers of the
+		// values found, f.ex. {"/user/id":7,"/items/0/sku":"a","/items/1/sku":"b"}.
+		inline bool parse_paths(const char *data, size_t size, const std::vector<std::string> &paths, value &out, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			out.set_type(rpoco::vt_object);
+			return parse_paths(data, size, paths, [&out](size_t /*path*/, const std::string &pointer, rpoco::visitor &v) {
+				rpoco::visit<value>(v, out.emplace(pointer));
+			}, allow_c_comments, utf16_to_utf8);
+		}
+		inline bool parse_paths(const std::string &text, const std::vector<std::string> &paths, value &out, bool allow_c_comments = false, bool utf16_to_utf8 = true) {
+			return parse_paths(text.data(), text.size(), paths, out, allow_c_comments, utf16_to_utf8);
+		}
+	}
+}
+
+#endif // __INCLUDED_RPOCO_JSON_PATHS_HPP__
@@ -0,0 +1,522 @@
+// This header provides an incremental (push) JSON parser for data that arrives in chunks,
+// f.ex. from a socket.
+
+// The push_parser is a state machine with an explicit stack of the open objects and arrays
+// so it can stop wherever a chunk runs out, even in the middle of a token, and carry on
+// with the next chunk. RPOCO objects are filled member by member and vectors element by
+// element as the data arrives, so only an unfinished token is kept between chunks. The
+// tokens themselves are converted by the regular parser.
+
+// Objects and arrays going to targets that can't be filled piecewise (maps, json::value's,
+// tuples, members with a select attribute, ...) are kept until they end and are then parsed
+// in one go, so those cost as much memory as their text.
+
+#ifndef __INCLUDED_RPOCO_JSON_PUSH_HPP__
+#define __INCLUDED_RPOCO_JSON_PUSH_HPP__
+
+#pragma once
+
+#include <rpoco/json.hpp>
+#include <memory>
+
+namespace rpoco {
+	namespace json {
+		// stands in for the parser when an object or array starts to find out if its target can be
+		// filled piecewise, that is if it's an RPOCO object or a vector. Anything else the target
+		// asks for rules that out, nothing is consumed.
+		struct push_probe : public rpoco::visitor {
+			rpoco::visit_type kind;
+			// the object to fill member by member
+			rpoco::member_provider *mp = nullptr;
+			void *obj = nullptr;
+			// the vector to fill element by element
+			std::unique_ptr<rpoco::element_sink> sink;
+			// was anything else asked for?
+			bool other = false;
+
+			push_probe(rpoco::visit_type kind) : kind(kind) {}
+			bool fillable() {
+				return !other && (mp || sink);
+			}
+			virtual rpoco::visit_type peek() {
+				return kind;
+			}
+			virtual bool consume_object(rpoco::member_provider &mp, void *obj) {
+				if (kind == rpoco::vt_object && !this->mp) {
+					this->mp = &mp;
+					this->obj = obj;
+				} else {
+					other = true;
+				}
+				return true;
+			}
+			virtual bool consume_elements(rpoco::element_sink &sink) {
+				if (kind != rpoco::vt_array || this->sink)
+					return false;
+				this->sink.reset(sink.clone());
+				return true;
+			}
+			virtual bool consume_map(const std::function<void(const std::string&)> &/*out*/) {
+				other = true;
+				return true;
+			}
+			virtual bool consume_array(const std::function<void()> &/*out*/) {
+				other = true;
+				return true;
+			}
+			virtual bool skip_unknown() {
+				other = true;
+				return true;
+			}
+			virtual void produce_start(rpoco::visit_type /*vt*/) {
+				other = true;
+			}
+			virtual void produce_end(rpoco::visit_type /*vt*/) {
+				other = true;
+			}
+			virtual void visit_null() {
+				other = true;
+			}
+			virtual void visit(bool &/*b*/) {
+				other = true;
+			}
+			virtual void visit(int &/*x*/) {
+				other = true;
+			}
+			virtual void visit(int64_t &/*x*/) {
+				other = true;
+			}
+			virtual void visit(uint64_t &/*x*/) {
+				other = true;
+			}
+			virtual void visit(float &/*x*/) {
+				other = true;
+			}
+			virtual void visit(double &/*x*/) {
+				other = true;
+			}
+			virtual void visit(std::string &/*k*/) {
+				other = true;
+			}
+			virtual void visit(rpoco::string_ref &/*x*/) {
+				other = true;
+			}
+			virtual void visit(char * /*str*/, size_t /*sz*/) {
+				other = true;
+			}
+			virtual void error(const std::string &/*err*/) {
+				other = true;
+			}
+		};
+
+		// The push parser fills the target as data arrives through feed calls, the data passed
+		// to feed has been consumed by the time it returns so the buffer can be reused for the
+		// next receive. Messages scattered over several buffers are simply fed one after another
+		// without joining them. The target must stay in place until finish has been called.
+		template<typename X>
+		class push_parser {
+			// where the parse is, the states up to s_done skip spaces (and comments) first.
+			enum state_t {
+				s_value, // a value
+				s_key, // a member name (or the end of an empty object)
+				s_colon, // the colon after a member name
+				s_next, // a comma or the end of the object or array
+				s_done, // the value has ended
+				s_string, // inside a string
+				s_escape, // after a backslash inside a string
+				s_scalar, // inside a number or true/false/null
+				s_slash, // after the slash starting a comment
+				s_line, // inside a line comment
+				s_block, // inside a block comment
+				s_block_star, // after a star inside a block comment
+				s_failed
+			};
+			// what the contents of an object or array go to
+			enum mode_t {
+				m_fill, // the target of the frame
+				m_collect, // kept and parsed once the outermost collected value ends
+				m_skip // nothing, it's only validated
+			};
+			// an open object or array, the ones being filled refer to their target.
+			struct frame {
+				char kind; // '{' or '['
+				bool empty;
+				// the object being filled and its JSON layout
+				rpoco::member_provider *mp;
+				json_typeinfo *jti;
+				void *obj;
+				int hint;
+				// the vector being filled
+				std::unique_ptr<rpoco::element_sink> sink;
+				// the member the array is the value of, it's the current member for the elements
+				rpoco::member *owner;
+			};
+			static const size_t none = (size_t)-1;
+
+			X *target;
+			bool allow_c_comments;
+			// converts tokens and collected values into their targets
+			json_parser<buffer_source> parser;
+			std::vector<frame> frames;
+			state_t state = s_value;
+			// the state to return to after a comment
+			state_t resume = s_value;
+			// is the string being read a member name?
+			bool in_key = false;
+			// the frames from this depth on are collected or skipped, none while filling.
+			size_t passive = none;
+			mode_t passive_mode = m_fill;
+			// the member of the innermost filled object that the next value goes to, nullptr for
+			// the extra field. Members that go nowhere are skipped.
+			rpoco::member *member = nullptr;
+			bool skipping = false;
+			std::string name;
+			// has the target of the collected value been probed already?
+			bool probed = false;
+			// the start of the token or collected value being read in the current chunk (nullptr if
+			// none), the part that arrived in earlier chunks is kept in held.
+			const char *from = nullptr;
+			std::string held;
+
+			push_parser(const push_parser&) = delete;
+			push_parser& operator=(const push_parser&) = delete;
+
+			static bool delimiter(char c) {
+				return is_space(c) || c == ',' || c == ':' || c == '}' || c == ']' || c == '{' || c == '[' || c == '"' || c == '/';
+			}
+			// the current member inside the innermost filled frame, as the regular parser would have it
+			rpoco::member* current_member() {
+				if (frames.empty())
+					return nullptr;
+				return frames.back().kind == '{' ? member : frames.back().owner;
+			}
+			// where the next value at the current depth goes
+			mode_t mode() {
+				if (passive != none)
+					return passive_mode;
+				if (!frames.empty() && frames.back().kind == '{' && skipping)
+					return m_skip;
+				return m_fill;
+			}
+			// visits the target of the next value in the innermost filled frame, again revisits
+			// an element already added for a probe.
+			void visit_target(rpoco::visitor &v, bool again) {
+				if (frames.empty()) {
+					rpoco::visit<X>(v, *target);
+					return;
+				}
+				frame &f = frames.back();
+				if (f.sink) {
+					if (again)
+						f.sink->last(v);
+					else
+						f.sink->add(v);
+				} else if (!member) {
+					f.jti->consume_extra(v, f.obj, name);
+				} else if (f.jti) {
+					f.jti->visit(member, v, f.obj);
+				} else {
+					member->visit(v, f.obj);
+				}
+			}
+			// points the parser at text to convert
+			void reset_parser(const char *text, size_t size) {
+				parser.src = buffer_source(text, size, false);
+				parser.ok = true;
+				parser.current_member = current_member();
+			}
+			bool parsed() {
+				parser.skip();
+				return parser.ok && EOF == parser.src.peek();
+			}
+			// the token or collected value ending at to, it's only valid until drop_held.
+			const char* take(const char *to, size_t &size) {
+				const char *text = from;
+				size = to - from;
+				if (!held.empty()) {
+					held.append(from, to);
+					text = held.data();
+					size = held.size();
+				}
+				from = nullptr;
+				return text;
+			}
+			void drop_held() {
+				held.clear();
+				// large collected values shouldn't keep their memory
+				if (held.capacity() > 64 * 1024)
+					std::string().swap(held);
+			}
+			void push_frame(char kind) {
+				frames.emplace_back();
+				frame &f = frames.back();
+				f.kind = kind;
+				f.empty = true;
+				f.mp = nullptr;
+				f.jti = nullptr;
+				f.obj = nullptr;
+				f.hint = 0;
+				f.owner = nullptr;
+			}
+			// a value at the current depth has ended
+			void ended() {
+				state = frames.empty() ? s_done : s_next;
+			}
+			// an object or array starts at p
+			void open(const char *p) {
+				char c = *p;
+				if (passive == none) {
+					mode_t m = mode();
+					rpoco::member *owner = current_member();
+					probed = false;
+					if (m == m_fill) {
+						// selected types are picked by a member that might come last
+						select_info *select = owner && c == '{' ? owner->attribute<select_info>() : nullptr;
+						if (select) {
+							m = m_collect;
+						} else {
+							push_probe probe(c == '{' ? rpoco::vt_object : rpoco::vt_array);
+							visit_target(probe, false);
+							probed = true;
+							if (probe.fillable()) {
+								push_frame(c);
+								frame &f = frames.back();
+								f.mp = probe.mp;
+								f.jti = probe.mp ? probe.mp->attribute<json_typeinfo>() : nullptr;
+								f.obj = probe.obj;
+								f.sink = std::move(probe.sink);
+								f.owner = owner;
+								return;
+							}
+							m = m_collect;
+						}
+					}
+					passive = frames.size();
+					passive_mode = m;
+					if (m == m_collect)
+						from = p;
+				}
+				push_frame(c);
+			}
+			// closes the innermost object or array, the bracket is at p
+			bool close(const char *p) {
+				frames.pop_back();
+				if (passive == frames.size()) {
+					if (passive_mode == m_collect) {
+						size_t size;
+						const char *text = take(p + 1, size);
+						reset_parser(text, size);
+						visit_target(parser, probed);
+						bool ok = parsed();
+						drop_held();
+						if (!ok)
+							return false;
+					}
+					passive = none;
+				}
+				ended();
+				return true;
+			}
+			// a string or scalar token ends at to
+			bool token(const char *to) {
+				mode_t m = passive == none && in_key ? m_fill : mode();
+				if (m == m_collect) {
+					if (in_key)
+						state = s_colon;
+					else
+						ended();
+					return true;
+				}
+				size_t size;
+				const char *text = take(to, size);
+				reset_parser(text, size);
+				bool ok;
+				if (m == m_skip) {
+					parser.skip_value();
+					ok = parsed();
+				} else if (in_key) {
+					// plain names are used as they are, others are decoded
+					size_t len = scan::verbatim_run(text + 1, size - 1);
+					if (len + 2 == size) {
+						name.assign(text + 1, len);
+						ok = true;
+					} else {
+						name.clear();
+						parser.visit(name);
+						ok = parsed();
+					}
+					frame &f = frames.back();
+					member = f.jti ? f.jti->find(name.data(), name.size(), f.hint) : f.mp->find(name.data(), name.size(), f.hint);
+					skipping = !member && !(f.jti && f.jti->has_extra());
+				} else {
+					visit_target(parser, false);
+					ok = parsed();
+				}
+				drop_held();
+				if (in_key)
+					state = s_colon;
+				else
+					ended();
+				return ok;
+			}
+			// handles the next character outside of tokens and comments, returns false on syntax errors.
+			bool structure(const char *&p) {
+				char c = *p;
+				if (c == '/' && allow_c_comments) {
+					resume = state;
+					state = s_slash;
+					p++;
+					return true;
+				}
+				switch (state) {
+				case s_value:
+					if (c == ']' && !frames.empty() && frames.back().kind == '[' && frames.back().empty)
+						return close(p++);
+					if (!frames.empty())
+						frames.back().empty = false;
+					if (c == '{' || c == '[') {
+						open(p++);
+						state = c == '{' ? s_key : s_value;
+						return true;
+					}
+					if (c != '"' && c != '-' && c != 't' && c != 'f' && c != 'n' && !is_digit(c))
+						return false;
+					in_key = false;
+					if (passive == none || passive_mode == m_skip)
+						from = p;
+					state = c == '"' ? s_string : s_scalar;
+					p++;
+					return true;
+				case s_key:
+					if (c == '}' && frames.back().empty)
+						return close(p++);
+					if (c != '"')
+						return false;
+					frames.back().empty = false;
+					in_key = true;
+					if (passive == none || passive_mode == m_skip)
+						from = p;
+					state = s_string;
+					p++;
+					return true;
+				case s_colon:
+					if (c != ':')
+						return false;
+					state = s_value;
+					p++;
+					return true;
+				case s_next:
+					if (c == ',') {
+						state = frames.back().kind == '{' ? s_key : s_value;
+						p++;
+						return true;
+					}
+					if (c != (frames.back().kind == '{' ? '}' : ']'))
+						return false;
+					return close(p++);
+				default:
+					// only spaces and comments may follow the value
+					return false;
+				}
+			}
+		public:
+			push_parser(X &x, bool allow_c_comments = false, bool utf16_to_utf8 = true) : target(&x), allow_c_comments(allow_c_comments), parser(buffer_source(nullptr, 0, false), allow_c_comments, utf16_to_utf8) {}
+
+			// feed a chunk of data to the parser, returns false as soon as the parse has failed.
+			bool feed(const char *data, size_t size) {
+				const char *p = data, *end = data + size;
+				if (!held.empty())
+					from = data;
+				while (p != end && state != s_failed) {
+					switch (state) {
+					case s_string:
+						while (p != end && *p != '"' && *p != '\\')
+							p++;
+						if (p == end)
+							break;
+						if (*p++ == '\\')
+							state = s_escape;
+						else if (!token(p))
+							state = s_failed;
+						break;
+					case s_escape:
+						p++;
+						state = s_string;
+						break;
+					case s_scalar:
+						while (p != end && !delimiter(*p))
+							p++;
+						if (p != end && !token(p))
+							state = s_failed;
+						break;
+					case s_slash:
+						if (*p == '/')
+							state = s_line;
+						else if (*p == '*')
+							state = s_block;
+						else
+							state = s_failed;
+						p++;
+						break;
+					case s_line:
+						// ended like the regular parser ends them
+						while (p != end && *p != '\r' && *p != '\n' && *p != '\f')
+							p++;
+						if (p != end)
+							state = resume;
+						break;
+					case s_block:
+						while (p != end && *p != '*')
+							p++;
+						if (p != end) {
+							p++;
+							state = s_block_star;
+						}
+						break;
+					case s_block_star:
+						state = *p == '/' ? resume : *p == '*' ? s_block_star : s_block;
+						p++;
+						break;
+					default:
+						if (is_space(*p))
+							p++;
+						else if (!structure(p))
+							state = s_failed;
+						break;
+					}
+				}
+				if (state == s_failed) {
+					from = nullptr;
+					drop_held();
+					return false;
+				}
+				// the unfinished token or collected value is kept for the next chunk
+				if (from)
+					held.append(from, end);
+				from = nullptr;
+				return true;
+			}
+			bool feed(const std::string &data) {
+				return feed(data.data(), data.size());
+			}
+
+			// the number of bytes kept between chunks, an unfinished token or a collected value.
+			size_t pending() const {
+				return held.size();
+			}
+
+			// signal that all data has been fed, returns true if a complete JSON value was parsed.
+			bool finish() {
+				// a number or constant at the top ends with the data
+				if (state == s_scalar && frames.empty()) {
+					from = held.data() + held.size();
+					if (!token(from))
+						state = s_failed;
+				}
+				return state == s_done || (state == s_line && resume == s_done);
+			}
+		};
+	}
+}
+
+#endif // __INCLUDED_RPOCO_JSON_PUSH_HPP__
@@ -0,0 +1,477 @@
+// This header provides a read only JSON document stored as one flat tape of tagged
+// 64 bit words and a string buffer, an alternative to json::value for large
+// documents where allocating every string, array and object separately dominates.
+
+// Every value is a word with the tag in the top byte and a payload in the rest.
+// Numbers are followed by a word with the bits of the double, or with the value itself for
+// integers that fit in 64 bits so that ids above 2^53 stay exact. Objects and arrays
+// start with a word holding the index of their end word and the end word holds the
+// count of members or elements, object members are a key string word followed by
+// the value. String words hold the offset into the string buffer where the length
+// is stored ahead of the (null terminated) string data.
+
+#ifndef __INCLUDED_RPOCO_JSON_TAPE_HPP__
+#define __INCLUDED_RPOCO_JSON_TAPE_HPP__
+
+#pragma once
+
+#include <rpoco/json.hpp>
+#include <string.h>
+
+namespace rpoco {
+	namespace json {
+		class tape {
+			std::vector<uint64_t> m_words;
+			std::string m_strings;
+			// strings being consumed, refers to the input when possible.
+			string_ref m_ref;
+
+			static const uint64_t payload_mask = (uint64_t(1) << 56) - 1;
+			static uint64_t word(char tag, uint64_t payload) {
+				return (uint64_t)(unsigned char)tag << 56 | payload;
+			}
+			char tag(size_t i) const {
+				return i < m_words.size() ? (char)(m_words[i] >> 56) : 'n';
+			}
+			uint64_t payload(size_t i) const {
+				return m_words[i] & payload_mask;
+			}
+			// index of the value after the one at i
+			size_t next(size_t i) const {
+				switch (tag(i)) {
+				case 'd':
+				case 'i':
+				case 'u':
+					return i + 2;
+				case '{':
+				case '[':
+					return (size_t)payload(i) + 1;
+				default:
+					return i + 1;
+				}
+			}
+			const char* string_at(size_t i, size_t &size) const {
+				const char *p = m_strings.data() + payload(i);
+				uint32_t len;
+				memcpy(&len, p, sizeof(len));
+				size = len;
+				return p + sizeof(len);
+			}
+			// state of an object or array being consumed
+			struct container {
+				tape *t;
+				visitor *v;
+				uint64_t count;
+			};
+			// lengths are stored in 32 bits, longer strings fail the parse and are left empty
+			// so that the tape stays well formed.
+			void add_string(visitor &v, const char *data, size_t size) {
+				if (size > UINT32_MAX) {
+					v.error("strings in a tape are limited to 4 GiB");
+					size = 0;
+				}
+				m_words.push_back(word('"', m_strings.size()));
+				uint32_t len = (uint32_t)size;
+				m_strings.append((const char*)&len, sizeof(len));
+				m_strings.append(data, size);
+				m_strings.push_back(0);
+			}
+		public:
+			class iterator;
+
+			// a reference to a value in the tape, valid as long as the tape is unchanged.
+			// Missing members and elements are null nodes.
+			class node {
+				friend class tape;
+				friend class iterator;
+				const tape *t;
+				size_t i;
+				node(const tape *t, size_t i) : t(t), i(i) {}
+				char tag() const {
+					return t ? t->tag(i) : 'n';
+				}
+			public:
+				node() : t(nullptr), i(0) {}
+
+				rpoco::visit_type type() const {
+					switch (tag()) {
+					case 't':
+					case 'f':
+						return rpoco::vt_bool;
+					case 'd':
+					case 'i':
+					case 'u':
+						return rpoco::vt_number;
+					case '"':
+						return rpoco::vt_string;
+					case '{':
+						return rpoco::vt_object;
+					case '[':
+						return rpoco::vt_array;
+					default:
+						return rpoco::vt_null;
+					}
+				}
+				bool is_null() const {
+					return tag() == 'n';
+				}
+				// false for missing members and elements, which read as null
+				bool exists() const {
+					return t != nullptr;
+				}
+				bool to_bool() const {
+					return tag() == 't';
+				}
+				double to_number() const {
+					switch (tag()) {
+					case 'd': {
+						double d;
+						memcpy(&d, &t->m_words[i + 1], sizeof(d));
+						return d;
+					}
+					case 'i':
+						return (double)(int64_t)t->m_words[i + 1];
+					case 'u':
+						return (double)t->m_words[i + 1];
+					default:
+						return 0;
+					}
+				}
+				// integers read from the input come back exact, other numbers are truncated and values
+				// outside of the range read as 0.
+				int64_t to_int64() const {
+					switch (tag()) {
+					case 'i':
+						return (int64_t)t->m_words[i + 1];
+					case 'u':
+						return t->m_words[i + 1] <= (uint64_t)INT64_MAX ? (int64_t)t->m_words[i + 1] : 0;
+					default: {
+						double d = to_number();
+						return d >= -9223372036854775808.0 && d < 9223372036854775808.0 ? (int64_t)d : 0;
+					}
+					}
+				}
+				uint64_t to_uint64() const {
+					switch (tag()) {
+					case 'i':
+						return (int64_t)t->m_words[i + 1] >= 0 ? t->m_words[i + 1] : 0;
+					case 'u':
+						return t->m_words[i + 1];
+					default: {
+						double d = to_number();
+						return d >= 0 && d < 18446744073709551616.0 ? (uint64_t)d : 0;
+					}
+					}
+				}
+				// string data, empty for other kinds of values
+				const char* c_str() const {
+					size_t size;
+					return tag() == '"' ? t->string_at(i, size) : "";
+				}
+				size_t length() const {
+					size_t size = 0;
+					if (tag() == '"')
+						t->string_at(i, size);
+					return size;
+				}
+				std::string to_string() const {
+					return std::string(c_str(), length());
+				}
+				// count of members or elements
+				size_t size() const {
+					char c = tag();
+					if (c != '{' && c != '[')
+						return 0;
+					return (size_t)t->payload((size_t)t->payload(i));
+				}
+				// members are searched in order
+				node find(const char *key, size_t len) const {
+					if (tag() != '{')
+						return node();
+					size_t end = (size_t)t->payload(i);
+					for (size_t j = i + 1;j < end;j = t->next(j + 1)) {
+						size_t size;
+						const char *name = t->string_at(j, size);
+						if (size == len && !memcmp(name, key, len))
+							return node(t, j + 1);
+					}
+					return node();
+				}
+				bool has(const std::string &key) const {
+					return find(key.data(), key.size()).exists();
+				}
+				node operator[](const std::string &key) const {
+					return find(key.data(), key.size());
+				}
+				node operator[](const char *key) const {
+					return find(key, strlen(key));
+				}
+				// elements are skipped over to reach the index
+				node operator[](int idx) const {
+					if (tag() != '[' || idx < 0)
+						return node();
+					size_t end = (size_t)t->payload(i);
+					size_t j = i + 1;
+					for (;idx && j < end;idx--)
+						j = t->next(j);
+					return j < end ? node(t, j) : node();
+				}
+				// iterates the elements of arrays or the members of objects
+				iterator begin() const;
+				iterator end() const;
+			};
+
+			class iterator {
+				friend class node;
+				const tape *t;
+				size_t i;
+				bool object;
+				iterator(const tape *t, size_t i, bool object) : t(t), i(i), object(object) {}
+			public:
+				node operator*() const {
+					return node(t, object ? i + 1 : i);
+				}
+				// the key of the current object member
+				const char* key() const {
+					size_t size;
+					return object ? t->string_at(i, size) : "";
+				}
+				size_t key_length() const {
+					size_t size = 0;
+					if (object)
+						t->string_at(i, size);
+					return size;
+				}
+				iterator& operator++() {
+					i = t->next(object ? i + 1 : i);
+					return *this;
+				}
+				bool operator==(const iterator &other) const {
+					return i == other.i;
+				}
+				bool operator!=(const iterator &other) const {
+					return i != other.i;
+				}
+			};
+
+			void clear() {
+				m_words.clear();
+				m_strings.clear();
+			}
+			// the top level value, null for an empty tape.
+			node root() const {
+				return m_words.empty() ? node() : node(this, 0);
+			}
+
+			// fills the tape from a visitor (used by the visit specialization)
+			void consume(visitor &v) {
+				switch (v.peek()) {
+				case rpoco::vt_null:
+					v.visit_null();
+					m_words.push_back(word('n', 0));
+					break;
+				case rpoco::vt_bool: {
+					bool b = false;
+					v.visit(b);
+					m_words.push_back(word(b ? 't' : 'f', 0));
+				} break;
+				case rpoco::vt_number: {
+					any_number x;
+					v.visit(x);
+					uint64_t bits;
+					switch (x.kind) {
+					case any_number::signed_integer:
+						m_words.push_back(word('i', 0));
+						m_words.push_back((uint64_t)x.i);
+						break;
+					case any_number::unsigned_integer:
+						m_words.push_back(word('u', 0));
+						m_words.push_back(x.u);
+						break;
+					default:
+						memcpy(&bits, &x.d, sizeof(bits));
+						m_words.push_back(word('d', 0));
+						m_words.push_back(bits);
+					}
+				} break;
+				case rpoco::vt_string:
+					v.visit(m_ref);
+					add_string(v, m_ref.data(), m_ref.size());
+					break;
+				case rpoco::vt_object: {
+					// the callbacks capture a single pointer so std::function doesn't allocate
+					container c = { this, &v, 0 };
+					size_t start = m_words.size();
+					m_words.push_back(0);
+					v.consume_map([&c](const std::string &key) {
+						c.t->add_string(*c.v, key.data(), key.size());
+						c.t->consume(*c.v);
+						c.count++;
+					});
+					m_words[start] = word('{', m_words.size());
+					m_words.push_back(word('}', c.count));
+				} break;
+				case rpoco::vt_array: {
+					container c = { this, &v, 0 };
+					size_t start = m_words.size();
+					m_words.push_back(0);
+					v.consume_array([&c]() {
+						c.t->consume(*c.v);
+						c.count++;
+					});
+					m_words[start] = word('[', m_words.size());
+					m_words.push_back(word(']', c.count));
+				} break;
+				default:
+					v.error("unknown value kind");
+				}
+			}
+			// produces the value at index i to a visitor (used by the visit specialization)
+			void produce(visitor &v, size_t i) const {
+				switch (tag(i)) {
+				case 't':
+				case 'f': {
+					bool b = tag(i) == 't';
+					v.visit(b);
+				} break;
+				case 'd': {
+					double d = node(this, i).to_number();
+					v.visit(d);
+				} break;
+				case 'i': {
+					int64_t iv = (int64_t)m_words[i + 1];
+					v.visit(iv);
+				} break;
+				case 'u': {
+					uint64_t uv = m_words[i + 1];
+					v.visit(uv);
+				} break;
+				case '"': {
+					size_t size;
+					const char *data = string_at(i, size);
+					string_ref s;
+					s.refer(data, size);
+					v.visit(s);
+				} break;
+				case '{': {
+					size_t end = (size_t)payload(i);
+					v.produce_start(rpoco::vt_object);
+					for (size_t j = i + 1;j < end && !v.stopped();j = next(j + 1)) {
+						size_t size;
+						const char *data = string_at(j, size);
+						string_ref key;
+						key.refer(data, size);
+						v.visit(key);
+						produce(v, j + 1);
+					}
+					v.produce_end(rpoco::vt_object);
+				} break;
+				case '[': {
+					size_t end = (size_t)payload(i);
+					v.produce_start(rpoco::vt_array);
+					for (size_t j = i + 1;j < end && !v.stopped();j = next(j))
+						produce(v, j);
+					v.produce_end(rpoco::vt_array);
+				} break;
+				default:
+					v.visit_null();
+				}
+			}
+		};
+
+		inline tape::iterator tape::node::begin() const {
+			char c = tag();
+			if (c != '{' && c != '[')
+				return iterator(t, 0, false);
+			return iterator(t, i + 1, c == '{');
+		}
+		inline tape::iterator tape::node::end() const {
+			char c = tag();
+			if (c != '{' && c != '[')
+				return iterator(t, 0, false);
+			return iterator(t, (size_t)t->payload(i), c == '{');
+		}
+	}
+
+	// tapes are filled when consuming and written out when producing
+	template<> struct visit<rpoco::json::tape> {
+		visit(visitor &v, rpoco::json::tape &t) {
+			if (v.peek() == vt_none) {
+				t.produce(v, 0);
+			} else {
+				t.clear();
+				t.consume(v);
+			}
+		}
+	};
+
+	// queries read from the tape, so templates can be rendered from tape documents.
+	template<> struct typedquery<rpoco::json::tape::node> : emptyquery {
+		rpoco::json::tape::node n;
+		// the query API hands out pointers to scalars
+		bool b;
+		double d;
+
+		typedquery(rpoco::json::tape::node *n) : n(*n) {}
+		typedquery(const rpoco::json::tape::node &n) : n(n) {}
+
+		virtual visit_type kind() {
+			return n.type();
+		}
+		virtual int size() {
+			return n.type() == vt_array ? (int)n.size() : 0;
+		}
+		virtual void all(std::function<void(const std::string&, query&)> out) {
+			if (n.type() != vt_object)
+				return;
+			for (auto it = n.begin();it != n.end();++it) {
+				typedquery<rpoco::json::tape::node> mq(*it);
+				out(std::string(it.key(), it.key_length()), mq);
+			}
+		}
+		virtual bool find(const std::string & name, std::function<void(query&)> out) {
+			rpoco::json::tape::node member = n.find(name.data(), name.size());
+			if (!member.exists())
+				return false;
+			typedquery<rpoco::json::tape::node> mq(member);
+			out(mq);
+			return true;
+		}
+		virtual void all(std::function<void(int, query&)> out) {
+			if (n.type() != vt_array)
+				return;
+			int idx = 0;
+			for (auto it = n.begin();it != n.end();++it) {
+				typedquery<rpoco::json::tape::node> mq(*it);
+				out(idx++, mq);
+			}
+		}
+		virtual bool at(int idx, std::function<void(query&)> out) {
+			if (n.type() != vt_array || idx < 0 || (size_t)idx >= n.size())
+				return false;
+			typedquery<rpoco::json::tape::node> mq(n[idx]);
+			out(mq);
+			return true;
+		}
+		virtual operator bool*() {
+			if (n.type() != vt_bool)
+				return nullptr;
+			b = n.to_bool();
+			return &b;
+		}
+		virtual operator double*() {
+			if (n.type() != vt_number)
+				return nullptr;
+			d = n.to_number();
+			return &d;
+		}
+		virtual std::string get() {
+			return n.to_string();
+		}
+	};
+	template<> struct typedquery<rpoco::json::tape> : typedquery<rpoco::json::tape::node> {
+		typedquery(rpoco::json::tape *t) : typedquery<rpoco::json::tape::node>(t->root()) {}
+	};
+}
+
+#endif // __INCLUDED_RPOCO_JSON_TAPE_HPP__
@@ -172,6 +172,10 @@ namespace rpoco {
 							} else if (double *dp=vq) {
 								auto ds=std::to_string(*dp);
 								ctx.dumpchars(ds.c_str(),ds.size());
+							} else {
+								// other integer types
+								auto ns=vq.get();
+								ctx.dumpchars(ns.c_str(),ns.size());
 							}
 						} else {
 							printf("Vt kind:%d not handled\n",vq.kind());
@@ -201,7 +205,7 @@ namespace rpoco {
 						if (vq.kind()==rpoco::vt_array) {
 							if (vq.size() && !invert) {
 								ctx.rstack.push_back(nullptr);
-								vq.all([&](int idx,rpoco::query &subq){
+								vq.all([&](int /*idx*/,rpoco::query &subq){
 									(ctx.rstack.back())=&subq;
 									sub.renderFragment(ctx);
 								});
@@ -215,7 +219,7 @@ namespace rpoco {
 							} else if (double *dp=vq) {
 								truthy=*ip!=0;
 							} else {
-								return;
+								truthy=vq.get()!="0";
 							}
 						} else if (vq.kind()==rpoco::vt_bool) {
 							truthy=*((bool*)vq);
@@ -34,10 +34,17 @@
 #include <typeinfo>
 #include <typeindex>
 #include <type_traits>
+#include <limits>
 #include <functional>
 #include <memory>
 #include <string.h>
 #include <cstddef>
+#include <algorithm>
+#if __cplusplus >= 201703L || _MSVC_LANG >= 201703L
+#include <string_view>
+#include <variant>
+#include <memory_resource>
+#endif
 
 // Use the RPOCO macro within a compound definition to create
 // automatic serialization information upon the specified members.
@@ -77,6 +84,177 @@ namespace rpoco {
 	// dummy struc used for visiting data without retaining any of it.
 	struct niltarget {};
 
+	// string_ref is a string field type that can refer to characters owned by someone else (like
+	// the input buffer of a parser) to avoid a copy, otherwise it holds a copy of its own.
+	// Referenced characters must outlive the string_ref and the string isn't null terminated.
+	class string_ref {
+		const char *m_data = "";
+		size_t m_size = 0;
+		// holds the characters when they couldn't be referenced
+		std::string m_copy;
+		bool m_owned = false;
+	public:
+		string_ref() {}
+		string_ref(const char *data, size_t size) : m_data(data), m_size(size) {}
+		string_ref(const char *str) : m_data(str), m_size(strlen(str)) {}
+		string_ref(const string_ref &other) {
+			*this = other;
+		}
+		string_ref& operator=(const string_ref &other) {
+			if (this != &other) {
+				if (other.m_owned)
+					assign(std::string(other.m_copy));
+				else
+					refer(other.m_data, other.m_size);
+			}
+			return *this;
+		}
+		string_ref(string_ref &&other) {
+			*this = std::move(other);
+		}
+		string_ref& operator=(string_ref &&other) {
+			if (this != &other) {
+				if (other.m_owned)
+					assign(std::move(other.m_copy));
+				else
+					refer(other.m_data, other.m_size);
+				other.refer("", 0);
+			}
+			return *this;
+		}
+
+		// refer to characters kept alive elsewhere
+		void refer(const char *data, size_t size) {
+			m_data = data;
+			m_size = size;
+			m_owned = false;
+			m_copy.clear();
+		}
+		// take ownership of a string
+		void assign(std::string &&str) {
+			m_copy = std::move(str);
+			m_data = m_copy.data();
+			m_size = m_copy.size();
+			m_owned = true;
+		}
+
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return !m_size; }
+		const char* begin() const { return m_data; }
+		const char* end() const { return m_data + m_size; }
+		// does this string_ref hold a copy rather than a reference?
+		bool owned() const { return m_owned; }
+		std::string str() const { return std::string(m_data, m_size); }
+#if __cplusplus >= 201703L || _MSVC_LANG >= 201703L
+		operator std::string_view() const { return std::string_view(m_data, m_size); }
+#endif
+
+		bool operator==(const string_ref &other) const {
+			return m_size == other.m_size && !memcmp(m_data, other.m_data, m_size);
+		}
+		bool operator!=(const string_ref &other) const {
+			return !(*this == other);
+		}
+	};
+
+	// any_number holds a number of the kind the input had, integers that fit in 64 bits are kept
+	// exact instead of being rounded to a double.
+	struct any_number {
+		enum kind_type { real, signed_integer, unsigned_integer };
+		kind_type kind = real;
+		double d = 0;
+		int64_t i = 0;
+		uint64_t u = 0;
+	};
+
+#if __cplusplus >= 201703L || _MSVC_LANG >= 201703L
+	// parsers can place their data in a memory resource instead of the global heap.
+	typedef std::pmr::memory_resource memory_resource;
+#else
+	// the same interface as std::pmr::memory_resource for compilers without it.
+	class memory_resource {
+	public:
+		virtual ~memory_resource() {}
+		void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+			return do_allocate(bytes, align);
+		}
+		void deallocate(void *p, size_t bytes, size_t align = alignof(std::max_align_t)) {
+			do_deallocate(p, bytes, align);
+		}
+		bool is_equal(const memory_resource &other) const noexcept {
+			return do_is_equal(other);
+		}
+	protected:
+		virtual void* do_allocate(size_t bytes, size_t align) = 0;
+		virtual void do_deallocate(void *p, size_t bytes, size_t align) = 0;
+		virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+	};
+#endif
+
+	// arena is a memory resource that hands out memory from large chunks and frees all of it at
+	// once with reset(), f.ex. after each request. Deallocation does nothing and an arena
+	// should only be used by one thread at a time.
+	class arena : public memory_resource {
+		struct chunk {
+			chunk *next;
+			size_t size;
+		};
+		chunk *m_chunks = nullptr;
+		char *m_cur = nullptr;
+		char *m_end = nullptr;
+		size_t m_chunk_size;
+
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		void add_chunk(size_t need) {
+			size_t size = std::max(m_chunk_size, need + sizeof(chunk));
+			chunk *c = (chunk*)::operator new(size);
+			c->next = m_chunks;
+			c->size = size;
+			m_chunks = c;
+			m_cur = (char*)(c + 1);
+			m_end = (char*)c + size;
+		}
+		static void free_chunks(chunk *c) {
+			while (c) {
+				chunk *next = c->next;
+				::operator delete(c);
+				c = next;
+			}
+		}
+	public:
+		explicit arena(size_t chunk_size = 64 * 1024) : m_chunk_size(chunk_size) {}
+		~arena() {
+			free_chunks(m_chunks);
+		}
+		// releases everything allocated, the latest chunk is kept for reuse.
+		void reset() {
+			chunk *keep = m_chunks;
+			if (!keep)
+				return;
+			free_chunks(keep->next);
+			keep->next = nullptr;
+			m_cur = (char*)(keep + 1);
+			m_end = (char*)keep + keep->size;
+		}
+	protected:
+		virtual void* do_allocate(size_t bytes, size_t align) {
+			uintptr_t p = ((uintptr_t)m_cur + align - 1) & ~(uintptr_t)(align - 1);
+			if (!m_cur || p + bytes > (uintptr_t)m_end) {
+				add_chunk(bytes + align);
+				p = ((uintptr_t)m_cur + align - 1) & ~(uintptr_t)(align - 1);
+			}
+			m_cur = (char*)(p + bytes);
+			return (void*)p;
+		}
+		virtual void do_deallocate(void * /*p*/, size_t /*bytes*/, size_t /*align*/) {}
+		virtual bool do_is_equal(const memory_resource &other) const noexcept {
+			return this == &other;
+		}
+	};
+
 	// (These names are subject to change, RPOCO started out with a visitation API but now it's also used for queries)
 	// visitation is done in a similar way both during creation (deserialization) and querying (serialization)
 	// vt_none is the result any querying system should provide when calling peek on the visitor while
@@ -92,6 +270,131 @@ namespace rpoco {
 		vt_string
 	};
 
+	// key_index is a perfect hash from a fixed set of names to their positions, it's built once
+	// per type so that looking up a key takes a single probe and compare on the raw characters.
+	// Keys are hashed into buckets and each bucket gets a displacement that moves all of
+	// its keys to free slots (the "hash and displace" scheme).
+	class key_index {
+		std::vector<std::string> m_names;
+		std::vector<int> m_positions; // position for each name
+		std::vector<int> m_at_position; // name at each position or -1 if it was overridden
+		std::vector<int> m_slots; // name for each slot or -1
+		std::vector<uint32_t> m_displacements; // one per bucket
+		uint64_t m_slot_mask = 0;
+		uint64_t m_bucket_mask = 0;
+
+		static uint64_t hash(const char *p, size_t len) {
+			uint64_t h = 0xcbf29ce484222325ULL ^ len;
+			for (;len >= 8;p += 8, len -= 8) {
+				uint64_t chunk;
+				memcpy(&chunk, p, 8);
+				h = (h ^ chunk) * 0x100000001b3ULL;
+				h ^= h >> 29;
+			}
+			for (;len;p++, len--)
+				h = (h ^ (unsigned char)*p) * 0x100000001b3ULL;
+			return h;
+		}
+		static uint64_t mix(uint64_t x) {
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			return x;
+		}
+		// try to place all names with the given table sizes
+		bool place(size_t slots, size_t buckets) {
+			m_slot_mask = slots - 1;
+			m_bucket_mask = buckets - 1;
+			m_slots.assign(slots, -1);
+			m_displacements.assign(buckets, 0);
+			std::vector<std::vector<int>> bucketed(buckets);
+			for (size_t i = 0;i < m_names.size();i++)
+				bucketed[(hash(m_names[i].data(), m_names[i].size()) >> 32) & m_bucket_mask].push_back((int)i);
+			// place the largest buckets first while there's the most room
+			std::vector<size_t> order(buckets);
+			for (size_t i = 0;i < buckets;i++)
+				order[i] = i;
+			std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return bucketed[a].size() > bucketed[b].size(); });
+			std::vector<uint64_t> taken;
+			for (size_t b : order) {
+				std::vector<int> &keys = bucketed[b];
+				if (keys.empty())
+					break;
+				uint32_t d = 0;
+				for (;d < 0x10000;d++) {
+					taken.clear();
+					bool fits = true;
+					for (int k : keys) {
+						uint64_t slot = mix(hash(m_names[k].data(), m_names[k].size()) + d) & m_slot_mask;
+						if (m_slots[slot] != -1 || std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+							fits = false;
+							break;
+						}
+						taken.push_back(slot);
+					}
+					if (fits)
+						break;
+				}
+				if (d == 0x10000)
+					return false;
+				m_displacements[b] = d;
+				for (size_t i = 0;i < keys.size();i++)
+					m_slots[taken[i]] = keys[i];
+			}
+			return true;
+		}
+	public:
+		// build the index, when a name occurs more than once the last position wins.
+		void build(const std::vector<std::string> &names) {
+			m_names.clear();
+			m_positions.clear();
+			m_at_position.assign(names.size(), -1);
+			for (size_t i = 0;i < names.size();i++) {
+				auto it = std::find(m_names.begin(), m_names.end(), names[i]);
+				if (it != m_names.end()) {
+					m_at_position[m_positions[it - m_names.begin()]] = -1;
+					m_positions[it - m_names.begin()] = (int)i;
+					m_at_position[i] = (int)(it - m_names.begin());
+				} else {
+					m_at_position[i] = (int)m_names.size();
+					m_names.push_back(names[i]);
+					m_positions.push_back((int)i);
+				}
+			}
+			m_slots.clear();
+			if (m_names.empty())
+				return;
+			size_t slots = 4;
+			while (slots < m_names.size() * 2)
+				slots *= 2;
+			while (!place(slots, slots / 4))
+				slots *= 2;
+		}
+		// position of the name or -1 if it isn't in the index
+		int find(const char *key, size_t len) const {
+			if (m_slots.empty())
+				return -1;
+			uint64_t h = hash(key, len);
+			int i = m_slots[mix(h + m_displacements[(h >> 32) & m_bucket_mask]) & m_slot_mask];
+			if (i < 0 || m_names[i].size() != len || memcmp(m_names[i].data(), key, len))
+				return -1;
+			return m_positions[i];
+		}
+		// keys usually arrive in declaration order so this first compares the key with the name at the
+		// hinted position before doing a hashed lookup, hint is updated to the position after the match.
+		int find(const char *key, size_t len, int &hint) const {
+			if (hint >= 0 && (size_t)hint < m_at_position.size()) {
+				int i = m_at_position[hint];
+				if (i >= 0 && m_names[i].size() == len && !memcmp(m_names[i].data(), key, len))
+					return hint++;
+			}
+			int pos = find(key, len);
+			if (pos >= 0)
+				hint = pos + 1;
+			return pos;
+		}
+	};
+
 	// a generic member provider class
 	class member_provider {
 	protected:
@@ -101,6 +404,15 @@ namespace rpoco {
 		virtual bool has(const std::string &id) = 0; // do we have the requested named member?
 		virtual member*& operator[](int idx) = 0; // get an indexed member (0-size() are valid indexes)
 		virtual member*& operator[](const std::string & id) = 0; // get a named member
+		// find a named member (or nullptr) from a key that isn't necessarily a std::string
+		virtual member* find(const char *id, size_t len) {
+			std::string name(id, len);
+			return has(name) ? (*this)[name] : nullptr;
+		}
+		// find with a hint about the position of the member, see key_index
+		virtual member* find(const char *id, size_t len, int &/*hint*/) {
+			return find(id, len);
+		}
 
 		// access a named attribute of the type (the attributes here are more akin to C++ compiler attributes or Java annotations than the OO term)
 		template<typename T>
@@ -135,6 +447,8 @@ namespace rpoco {
 		virtual std::type_index type_index() = 0;
 		// visit the current member on the subject object
 		virtual void visit(visitor &v, void *subject) = 0;
+		// reset the current member on the subject object, see rpoco::reset
+		virtual void reset(void *subject) = 0;
 		// query the current member on the subject object
 		virtual void query(std::function<void(query&) >, void*) = 0;
 
@@ -155,24 +469,95 @@ namespace rpoco {
 	};
 
 
+	// receives the elements of an array one at a time for visitors that can't consume a whole array
+	// in one call (f.ex. a parser fed data in chunks). Sinks refer to their container so they're
+	// only valid as long as it isn't moved or destroyed.
+	class element_sink {
+	public:
+		virtual ~element_sink() {}
+		// adds an element and visits it
+		virtual void add(visitor &v) = 0;
+		// visits the element added last again
+		virtual void last(visitor &v) = 0;
+		// a copy of the sink to keep after the visit
+		virtual element_sink* clone() const = 0;
+	};
+
+	// function to visit an object constructed by a visitor as its actual (possibly derived) type
+	typedef void (*visit_fn)(visitor &v, void *obj);
+
 	// subclass this type to enumerate data structures.
 	class visitor {
 	protected:
 		// internal construction method.
-		virtual void * construct(std::type_index idx) { return nullptr; }
+		virtual void * construct(std::type_index /*idx*/) { return nullptr; }
+		// construction of polymorphic objects, visit_as is set when the constructed object
+		// should be visited as another type than the one requested.
+		virtual void * construct(std::type_index idx, visit_fn &visit_as) {
+			visit_as = nullptr;
+			return construct(idx);
+		}
+		// the type that the data selects for an object of type idx (f.ex. through a json select
+		// attribute) or nullptr, visit_as is set to visit an object of the selected type.
+		virtual const std::type_info* selected(std::type_index /*idx*/, visit_fn &visit_as) {
+			visit_as = nullptr;
+			return nullptr;
+		}
 	public:
+		// the memory resource that parsed data should be placed in, nullptr for the global heap.
+		virtual memory_resource* resource() {
+			return nullptr;
+		}
+		// should consumed vectors be overwritten element by element (keeping their elements and
+		// capacity) instead of appended to?
+		virtual bool reusing() {
+			return false;
+		}
+		// producing visitors that can't take any more (f.ex. a writer whose output failed) return
+		// true so that the members and elements left aren't visited.
+		virtual bool stopped() {
+			return false;
+		}
+		// the number of elements in the upcoming array if the visitor can tell cheaply, 0 otherwise.
+		// The hint is used to reserve count * element_size bytes up front, so visitors of untrusted
+		// input keep that within a few times the size of the array's own data.
+		virtual size_t size_hint(size_t /*element_size*/) {
+			return 0;
+		}
+		// consumes a whole array of numbers into a vector in one go instead of element by element,
+		// visitors without a bulk path return false and leave the input as is.
+		virtual bool consume_numbers(std::vector<int> &/*out*/) {
+			return false;
+		}
+		virtual bool consume_numbers(std::vector<int64_t> &/*out*/) {
+			return false;
+		}
+		virtual bool consume_numbers(std::vector<uint64_t> &/*out*/) {
+			return false;
+		}
+		virtual bool consume_numbers(std::vector<float> &/*out*/) {
+			return false;
+		}
+		virtual bool consume_numbers(std::vector<double> &/*out*/) {
+			return false;
+		}
 		virtual visit_type peek()=0; // return vt_none if querying objects, otherwise return the next data type.
 
 		virtual bool consume_object(member_provider &mp,void *obj) = 0; // used by members to start consuming data from complex input objects during creation
 		virtual bool consume_map(const std::function<void(const std::string&)> &out) = 0; // used by members to start consuming data from complex input objects during creation
 		virtual bool consume_array(const std::function<void()> &out) = 0; // used by members to start consuming data from complex input objects during creation
+		// visitors that take the elements of the upcoming array later on keep a clone of the sink
+		// and return true, the others return false to have it consumed with consume_array.
+		virtual bool consume_elements(element_sink &/*sink*/) {
+			return false;
+		}
 
 																		  // a generic object production method, can be overridden by visitors that needs special semantics.
 		virtual void produce_object(member_provider &mp, void *obj) {
 			// we're in production mode so produce
 			// data from our members
 			produce_start(vt_object);
-			for (int i = 0;i<mp.size();i++) {
+			for (int i = 0;i<mp.size() && !stopped();i++) {
 				visit(mp[i]->name());
 				mp[i]->visit(*this, obj);
 			}
@@ -193,11 +578,90 @@ namespace rpoco {
 		virtual void visit(char *,size_t sz)=0;
 		virtual void error(const std::string &err)=0;
 
+		// 64 bit integers, visitors without native support for them pass the values through a double.
+		virtual void visit(int64_t& x) {
+			visit_through_double(x);
+		}
+		virtual void visit(uint64_t& x) {
+			visit_through_double(x);
+		}
+		// numbers of any kind, visitors that can't tell integers from other numbers read a double.
+		virtual void visit(any_number &x) {
+			if (peek() != vt_none) {
+				x.kind = any_number::real;
+				visit(x.d);
+				return;
+			}
+			switch (x.kind) {
+			case any_number::signed_integer:
+				visit(x.i);
+				break;
+			case any_number::unsigned_integer:
+				visit(x.u);
+				break;
+			default:
+				visit(x.d);
+			}
+		}
+		// strings that may refer to the input, visitors that can't refer to their input use a copy.
+		virtual void visit(string_ref &x) {
+			bool consuming = peek() != vt_none;
+			std::string tmp;
+			if (consuming) {
+				visit(tmp);
+				x.assign(std::move(tmp));
+			} else {
+				tmp.assign(x.data(), x.size());
+				visit(tmp);
+			}
+		}
+	private:
+		template<typename I>
+		void visit_through_double(I &x) {
+			double d = (double)x;
+			bool consuming = peek() != vt_none;
+			visit(d);
+			if (consuming)
+				x = (I)d;
+		}
+	public:
+
+		// hands over the upcoming value as raw text in the visitor's format instead of visiting it so
+		// that it can be parsed later on demand, visitors that can't do that return false. options
+		// gets the visitor specific flags needed to read the text back the same way.
+		virtual bool capture(string_ref &/*raw*/, unsigned &/*options*/) {
+			return false;
+		}
+
+		// skips over the upcoming value that nothing wants (unknown fields), visitors that can find
+		// its end cheaper than visiting it do so and return true.
+		virtual bool skip_unknown() {
+			return false;
+		}
+
+		// picks the alternative of a variant to consume the upcoming data into, kinds holds the kind of
+		// data each alternative takes. The default picks the first alternative of the kind peeked.
+		virtual int choose(const std::type_index * /*types*/, const visit_type *kinds, int count) {
+			visit_type vt = peek();
+			for (int i = 0;i < count;i++)
+				if (kinds[i] == vt)
+					return i;
+			return -1;
+		}
+
 		// templated construction method
 		template<typename T>
 		T* construct() {
 			return (T*)construct(std::type_index(typeid(T)));
 		}
+		template<typename T>
+		T* construct(visit_fn &visit_as) {
+			return (T*)construct(std::type_index(typeid(T)), visit_as);
+		}
+		template<typename T>
+		const std::type_info* selected(visit_fn &visit_as) {
+			return selected(std::type_index(typeid(T)), visit_as);
+		}
 	};
 	
 	// The query API interface, implemented by subclasses.
@@ -241,15 +705,15 @@ namespace rpoco {
 	struct emptyquery : query {
 		virtual int size() { return 0; }
 		virtual void all(std::function<void(const std::string&,query&)>) {}
-		virtual bool find(const std::string & name,std::function<void(query&)>) {
+		virtual bool find(const std::string & /*name*/,std::function<void(query&)>) {
 			return false;
 		}
-		virtual void add(std::string & name,std::function<void(query&)> q) {
+		virtual void add(std::string & /*name*/,std::function<void(query&)> q) {
 			q(*this);
 		}
 
 		virtual void all(std::function<void(int,query&)>) {}
-		virtual bool at(int idx,std::function<void(query&)>) {
+		virtual bool at(int /*idx*/,std::function<void(query&)>) {
 			return false;
 		}
 		virtual void add(std::function<void(query&)> q) {
@@ -260,7 +724,7 @@ namespace rpoco {
 		virtual operator int*() { return 0; }
 		virtual operator double*() { return 0; }
 		virtual void set(const char *) {}
-		virtual void set(std::string &k) {}
+		virtual void set(std::string &/*k*/) {}
 		virtual std::string get() { return std::string("empty"); }; // no good!
 	};
 	struct nonequery : emptyquery {
@@ -291,13 +755,13 @@ namespace rpoco {
 			(*fp)[name]->query(qt,p);
 			return true;
 		}
-		virtual void add(std::string & name,std::function<void(query&)> q) {
+		virtual void add(std::string & /*name*/,std::function<void(query&)> q) {
 			nonequery nq;
 			q(nq);
 		}
 
 		virtual void all(std::function<void(int,query&)>) {}
-		virtual bool at(int idx,std::function<void(query&)>) {
+		virtual bool at(int /*idx*/,std::function<void(query&)>) {
 			return false;
 		}
 		virtual void add(std::function<void(query&)> q) {
@@ -309,7 +773,7 @@ namespace rpoco {
 		virtual operator int*() { return 0; }
 		virtual operator double*() { return 0; }
 		virtual void set(const char *) {}
-		virtual void set(std::string &k) {}
+		virtual void set(std::string &/*k*/) {}
 		virtual std::string get() { return std::string("Obj"); }; // no good!
 	};
 
@@ -317,10 +781,10 @@ namespace rpoco {
 	typedquery<F> make_query(F &f);
 
 	// typed-query for std::vector
-	template<typename F>
-	struct typedquery<std::vector<F>> : emptyquery {
-		std::vector<F> *p;
-		typedquery(std::vector<F> *v) {
+	template<typename F, typename A>
+	struct typedquery<std::vector<F, A>> : emptyquery {
+		std::vector<F, A> *p;
+		typedquery(std::vector<F, A> *v) {
 			p=v;
 		}
 		virtual visit_type kind() { return vt_array; }
@@ -391,23 +855,23 @@ namespace rpoco {
 		}
 	};
 
-	// basic type specializations
-	template<>
-	struct typedquery<std::string> : emptyquery {
-		std::string *p;
-		typedquery(std::string *str) {
+	// basic type specializations (strings with any allocator)
+	template<typename A>
+	struct typedquery<std::basic_string<char, std::char_traits<char>, A>> : emptyquery {
+		std::basic_string<char, std::char_traits<char>, A> *p;
+		typedquery(std::basic_string<char, std::char_traits<char>, A> *str) {
 			p=str;
 		}
 
 		virtual visit_type kind() { return vt_string; }
 		virtual void set(const char *cp) {
-			(*p)=std::string(cp);
+			p->assign(cp);
 		}
 		virtual void set(std::string &k) {
-			(*p)=k;
+			p->assign(k.data(), k.size());
 		}
 		virtual std::string get() {
-			return *p;
+			return std::string(p->data(), p->size());
 		}
 	};
 	
@@ -423,6 +887,26 @@ namespace rpoco {
 		} 
 	};
 
+	// the remaining integer types are queried as numbers with a string representation.
+	template<typename I>
+	struct integerquery : emptyquery {
+		I *ip;
+		integerquery(I *iv) {
+			ip=iv;
+		}
+		virtual visit_type kind() { return vt_number; }
+		virtual std::string get() {
+			return std::to_string(*ip);
+		}
+	};
+	template<> struct typedquery<int64_t> : integerquery<int64_t> { typedquery(int64_t *iv) : integerquery(iv) {} };
+	template<> struct typedquery<uint64_t> : integerquery<uint64_t> { typedquery(uint64_t *iv) : integerquery(iv) {} };
+	template<> struct typedquery<uint32_t> : integerquery<uint32_t> { typedquery(uint32_t *iv) : integerquery(iv) {} };
+	template<> struct typedquery<int16_t> : integerquery<int16_t> { typedquery(int16_t *iv) : integerquery(iv) {} };
+	template<> struct typedquery<uint16_t> : integerquery<uint16_t> { typedquery(uint16_t *iv) : integerquery(iv) {} };
+	template<> struct typedquery<int8_t> : integerquery<int8_t> { typedquery(int8_t *iv) : integerquery(iv) {} };
+	template<> struct typedquery<uint8_t> : integerquery<uint8_t> { typedquery(uint8_t *iv) : integerquery(iv) {} };
+
 	template<>
 	struct typedquery<float> : emptyquery {
 		float *fp;
@@ -458,6 +942,24 @@ namespace rpoco {
 		}
 	};
 
+	template<>
+	struct typedquery<string_ref> : emptyquery {
+		string_ref *p;
+		typedquery(string_ref *sr) {
+			p=sr;
+		}
+		virtual visit_type kind() { return vt_string; }
+		virtual void set(const char *cp) {
+			p->assign(std::string(cp));
+		}
+		virtual void set(std::string &k) {
+			p->assign(std::string(k));
+		}
+		virtual std::string get() {
+			return p->str();
+		}
+	};
+
 	template<>
 	struct typedquery<char const *> : emptyquery {
 		const char **ptr;
@@ -467,10 +969,10 @@ namespace rpoco {
 		virtual visit_type kind() {
 			return vt_string;
 		}
-		virtual void set(const char *cp) {
+		virtual void set(const char * /*cp*/) {
 			abort(); // const char consts's are write-only
 		}
-		virtual void set(std::string &k) {
+		virtual void set(std::string &/*k*/) {
 			abort(); // const char consts's are write-only
 		}
 		virtual std::string get() {
@@ -544,7 +1046,7 @@ namespace rpoco {
 		virtual operator float*() { return nullptr; }
 		virtual operator double*() { return nullptr; }
 		virtual void set(const char *) {}
-		virtual void set(std::string &k) {}
+		virtual void set(std::string &/*k*/) {}
 		virtual std::string get() { return ""; };
 	};
 
@@ -578,7 +1080,7 @@ namespace rpoco {
 				return (*sq).find(name,q);
 			return false;
 		}
-		virtual void add(std::string & name,std::function<void(query&)>) {
+		virtual void add(std::string & /*name*/,std::function<void(query&)>) {
 			// TODO
 		}
 
@@ -641,6 +1143,25 @@ namespace rpoco {
 	};
 
 
+#if __cplusplus >= 201703L || _MSVC_LANG >= 201703L
+	// variants are queried through their current alternative
+	template<typename ...T>
+	struct typedquery<std::variant<T...>> : pointertypedquery<std::variant<T...>> {
+		typedquery(std::variant<T...> *v) {
+			this->p = v->valueless_by_exception() ? nullptr : v;
+			if (this->p)
+				this->sq = std::visit([](auto &alt) -> std::unique_ptr<query> {
+					return std::make_unique<typedquery<typename std::decay<decltype(alt)>::type>>(&alt);
+				}, *v);
+		}
+	};
+	template<>
+	struct typedquery<std::monostate> : nonequery {
+		typedquery(std::monostate *) {}
+		virtual visit_type kind() { return vt_null; }
+	};
+#endif
+
 	template<typename F>
 	struct typedquery<F *> : public pointertypedquery<F> {
 
@@ -685,6 +1206,9 @@ namespace rpoco {
 	// map visitation
 	template<typename F>
 	struct visit<std::map<std::string,F>> { visit(visitor &v,std::map<std::string,F> &mp) {
+		// reused maps only keep the entries of the new object
+		if (v.reusing() && v.peek() == vt_object)
+			mp.clear();
 		if (v.consume_map([&v,&mp](const std::string& x) {
 				// just produce new entries during consumption
 				rpoco::visit<F>(v, mp[x] );
@@ -696,6 +1220,8 @@ namespace rpoco {
 			// members to a target object.
 			v.produce_start(vt_object);
 			for (std::pair<std::string,F> p:mp) {
+				if (v.stopped())
+					break;
 				rpoco::visit<std::string>(v,p.first);
 				rpoco::visit<F>(v,p.second);
 			}
@@ -707,7 +1233,9 @@ namespace rpoco {
 	// can consume any type thrown at it and is used
 	// to ignore unknown incomming data
 	template<>
-	struct visit<niltarget> { visit(visitor &v,niltarget &nt) {
+	struct visit<niltarget> { visit(visitor &v,niltarget &/*nt*/) {
+		if (v.skip_unknown())
+			return;
 		visit_type vtn;
 		switch(vtn=v.peek()) {
 		case vt_null :
@@ -732,7 +1260,7 @@ namespace rpoco {
 				});
 			} break;
 		case vt_object : {
-				v.consume_map([&v](const std::string& propname) {
+				v.consume_map([&v](const std::string& /*propname*/) {
 					niltarget ntn;
 					//std::cout<<"Ignoring prop:"<<propname<<"\n";
 					rpoco::visit<niltarget>(v,ntn);
@@ -749,20 +1277,141 @@ namespace rpoco {
 		rpoco::visit<niltarget>(v,nt);
 	}
 
-	// vector visitor, used for arrays
+	// vectors of the common number types are handed to the visitor in one go when consuming, keep
+	// is the count of existing elements to keep.
+	template<typename F, typename A>
+	bool consume_numbers(visitor &/*v*/, std::vector<F, A> &/*vp*/, size_t /*keep*/) {
+		return false;
+	}
 	template<typename F>
-	struct visit<std::vector<F>> { visit(visitor &v,std::vector<F> &vp) {
-		if (v.consume_array([&v,&vp]() {
+	bool consume_number_vector(visitor &v, std::vector<F> &vp, size_t keep) {
+		// the elements are only dropped once an array is coming
+		if (v.peek() != vt_array)
+			return false;
+		vp.resize(keep);
+		return v.consume_numbers(vp);
+	}
+	inline bool consume_numbers(visitor &v, std::vector<int> &vp, size_t keep) {
+		return consume_number_vector(v, vp, keep);
+	}
+	inline bool consume_numbers(visitor &v, std::vector<int64_t> &vp, size_t keep) {
+		return consume_number_vector(v, vp, keep);
+	}
+	inline bool consume_numbers(visitor &v, std::vector<uint64_t> &vp, size_t keep) {
+		return consume_number_vector(v, vp, keep);
+	}
+	inline bool consume_numbers(visitor &v, std::vector<float> &vp, size_t keep) {
+		return consume_number_vector(v, vp, keep);
+	}
+	inline bool consume_numbers(visitor &v, std::vector<double> &vp, size_t keep) {
+		return consume_number_vector(v, vp, keep);
+	}
+
+	// resets a value the way a fresh object has it, used by reusing visitors for the members that the
+	// input leaves out. Strings and vectors are cleared so that they keep their capacity, members
+	// of rpoco types are reset one by one and pointer targets are released.
+	template<typename F>
+	void reset_value(F &f, decltype(&F::rpoco_type_info_get,(void*)nullptr)) {
+		member_provider *mp = f.rpoco_type_info_get();
+		for (int i = 0;i < mp->size();i++)
+			(*mp)[i]->reset(&f);
+	}
+	template<typename F>
+	void reset_value(F &f, ...) {
+		f = F();
+	}
+	template<typename F>
+	void reset(F &f) {
+		reset_value(f, nullptr);
+	}
+	template<typename C, typename T, typename A>
+	void reset(std::basic_string<C, T, A> &s) {
+		s.clear();
+	}
+	template<typename F>
+	void reset(F *&fp) {
+		delete fp;
+		fp = nullptr;
+	}
+	// C-string members are constants that the input is checked against
+	inline void reset(char const *&) {
+	}
+	template<int SZ>
+	void reset(char (&str)[SZ]) {
+		str[0] = 0;
+	}
+	template<typename F, typename A>
+	void reset(std::vector<F, A> &vp) {
+		// the elements only own something that clear() doesn't release if they're raw pointers
+		if (std::is_pointer<F>::value) {
+			for (F &f : vp)
+				rpoco::reset(f);
+		}
+		vp.clear();
+	}
+
+	// adds the elements of a vector through an element_sink
+	template<typename F, typename A>
+	class vector_sink : public element_sink {
+		std::vector<F, A> *vp;
+	public:
+		vector_sink(std::vector<F, A> &vp) : vp(&vp) {}
+		virtual void add(visitor &v) {
+			vp->emplace_back();
+			rpoco::visit<F>(v, vp->back());
+		}
+		virtual void last(visitor &v) {
+			rpoco::visit<F>(v, vp->back());
+		}
+		virtual element_sink* clone() const {
+			return new vector_sink(*this);
+		}
+	};
+
+	// vector visitor, used for arrays (with any allocator, f.ex. std::pmr::vector)
+	template<typename F, typename A>
+	struct visit<std::vector<F, A>> { visit(visitor &v,std::vector<F, A> &vp) {
+		// visitors that add the elements later on are handed a sink
+		vector_sink<F, A> sink(vp);
+		if (v.consume_elements(sink))
+			return;
+		// when reusing, existing elements are overwritten and the leftovers dropped afterwards,
+		// the state is captured through a single pointer so that std::function doesn't allocate.
+		struct consumer {
+			visitor *v;
+			std::vector<F, A> *vp;
+			size_t count;
+		} c = { &v, &vp, v.reusing() ? 0 : vp.size() };
+		// elements are only dropped when an array replaces them
+		bool array = v.peek() == vt_array;
+		// vectors grow once to fit the elements when their count is known ahead, counting costs a
+		// pass over the array so small plain structs that are cheap to move are left to grow.
+		bool count_ahead = std::is_arithmetic<F>::value || !std::is_trivially_copyable<F>::value || sizeof(F) > 64;
+		if (size_t hint = count_ahead ? v.size_hint(sizeof(F)) : 0)
+			vp.reserve(c.count + hint);
+		if (consume_numbers(v, vp, c.count))
+			return;
+		if (v.consume_array([&c]() {
 				// consumption of incoming data
-				vp.emplace_back();
-				rpoco::visit<F>(v,vp.back());
+				if (c.count == c.vp->size())
+					c.vp->emplace_back();
+				rpoco::visit<F>(*c.v,(*c.vp)[c.count++]);
 			}))
 		{
+			if (array) {
+				if (std::is_pointer<F>::value) {
+					for (size_t i = c.count;i < vp.size();i++)
+						rpoco::reset(vp[i]);
+				}
+				vp.erase(vp.begin() + c.count, vp.end());
+			}
 			return ;
 		} else {
 			// production of outgoing data
 			v.produce_start(vt_array);
 			for (F &f:vp) {
+				if (v.stopped())
+					break;
 				rpoco::visit<F>(v,f);
 			}
 			v.produce_end(vt_array);
@@ -808,16 +1457,99 @@ namespace rpoco {
 		}
 	};
 
+	// the kind of data a type consumes, used when picking variant alternatives.
+	template<typename F> struct value_kind { static const visit_type kind = vt_object; };
+	template<> struct value_kind<bool> { static const visit_type kind = vt_bool; };
+	template<> struct value_kind<int> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<int64_t> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<uint64_t> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<uint32_t> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<int16_t> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<uint16_t> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<int8_t> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<uint8_t> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<float> { static const visit_type kind = vt_number; };
+	template<> struct value_kind<double> { static const visit_type kind = vt_number; };
+	template<typename A> struct value_kind<std::basic_string<char, std::char_traits<char>, A>> { static const visit_type kind = vt_string; };
+	template<> struct value_kind<string_ref> { static const visit_type kind = vt_string; };
+	template<> struct value_kind<const char*> { static const visit_type kind = vt_string; };
+	template<typename F, typename A> struct value_kind<std::vector<F, A>> { static const visit_type kind = vt_array; };
+	template<typename ...T> struct value_kind<std::tuple<T...>> { static const visit_type kind = vt_array; };
+	template<typename F> struct value_kind<F*> : value_kind<F> {};
+	template<typename F> struct value_kind<std::shared_ptr<F>> : value_kind<F> {};
+	template<typename F> struct value_kind<std::unique_ptr<F>> : value_kind<F> {};
+
+#if __cplusplus >= 201703L || _MSVC_LANG >= 201703L
+	template<> struct value_kind<std::monostate> { static const visit_type kind = vt_null; };
+
+	// monostate alternatives of variants are visited as null
+	template<> struct visit<std::monostate> { visit(visitor &v, std::monostate &) {
+		v.visit_null();
+	}};
+
+	// variant visitation, the visitor chooses which alternative to consume data into.
+	template<typename ...T>
+	struct visit<std::variant<T...>> {
+		visit(visitor &v, std::variant<T...> &var) {
+			if (v.peek() == vt_none) {
+				if (var.valueless_by_exception())
+					v.visit_null();
+				else
+					std::visit([&v](auto &alt) { rpoco::visit<typename std::decay<decltype(alt)>::type>(v, alt); }, var);
+				return;
+			}
+			static const std::type_index types[] = { std::type_index(typeid(T))... };
+			static const visit_type kinds[] = { value_kind<T>::kind... };
+			int idx = v.choose(types, kinds, (int)sizeof...(T));
+			if (idx < 0) {
+				v.error("No variant alternative matches the data");
+				visit_nil(v);
+				return;
+			}
+			consume<0, T...>(v, var, idx);
+		}
+
+		template<size_t N>
+		static void consume(visitor &, std::variant<T...> &, int) {}
+		template<size_t N, typename H, typename ...R>
+		static void consume(visitor &v, std::variant<T...> &var, int idx) {
+			if (idx == (int)N) {
+				if (var.index() != N)
+					var.template emplace<N>();
+				rpoco::visit<H>(v, std::get<N>(var));
+			} else {
+				consume<N + 1, R...>(v, var, idx);
+			}
+		}
+	};
+#endif
+
 	// special handling for allocating rpoco managed types (since we will allow for polymorphism if the visitor wants it!)
 	template<typename F>
-	void visit_ptrtarget(F* ptr,const std::function<void(F*)> &alloccb,visitor &v,decltype(&F::rpoco_type_info_get,(void*)nullptr) b) {
+	void visit_ptrtarget(F* ptr,const std::function<void(F*)> &alloccb,visitor &v,decltype(&F::rpoco_type_info_get,(void*)nullptr)) {
+		visit_fn visit_as = nullptr;
+		// reused targets are released by a null, visited as the type the data selects and
+		// replaced if that's another type
+		if (ptr && v.reusing()) {
+			if (v.peek() == vt_null) {
+				alloccb(nullptr);
+				ptr = nullptr;
+			} else if (const std::type_info *type = v.selected<F>(visit_as)) {
+				if (*type != typeid(*ptr)) {
+					ptr = nullptr;
+					visit_as = nullptr;
+				}
+			}
+		}
 		if (v.peek() != vt_null && v.peek() != vt_none && !ptr) {
-			ptr = v.construct<F>();
+			ptr = v.construct<F>(visit_as);
 			if (!ptr)
 				ptr = new F();
 			alloccb(ptr);
 		}
-		if (ptr)
+		if (ptr && visit_as)
+			visit_as(v, ptr); // a derived type was constructed
+		else if (ptr)
 			visit<F>(v, *ptr);
 		else
 			v.visit_null();
@@ -826,6 +1558,10 @@ namespace rpoco {
 	// regular objects are just allocated and visited normally.
 	template<typename F>
 	void visit_ptrtarget(F* ptr,const std::function<void(F*)> &alloccb,visitor &v,...) {
+		if (ptr && v.reusing() && v.peek() == vt_null) {
+			alloccb(nullptr);
+			ptr = nullptr;
+		}
 		if (v.peek() != vt_null && v.peek() != vt_none && !ptr) {
 			ptr = new F();
 			alloccb(ptr);
@@ -839,9 +1575,12 @@ namespace rpoco {
 	// the pointer visitor creates a new object of the specified type
 	// during consumption so destructors should
 	// always check for the presence and destroy if needed.
+	// (targets stay on the heap even when the visitor has a memory resource
+	// since owners release them with delete, as does a reusing visitor that replaces them)
 	template<typename F>
 	struct visit<F*> { visit(visitor &v,F *& fp) {
 		std::function<void(F*)> cb([&fp](F* inv) {
+			delete fp;
 			fp = inv;
 		});
 		visit_ptrtarget(fp, cb, v,nullptr);
@@ -873,6 +1612,39 @@ namespace rpoco {
 		}
 	};
 
+	// 64 bit integer visitation
+	template<> struct visit<int64_t> {
+		visit(visitor &v,int64_t &ip) {
+			v.visit(ip);
+		}
+	};
+	template<> struct visit<uint64_t> {
+		visit(visitor &v,uint64_t &ip) {
+			v.visit(ip);
+		}
+	};
+
+	// smaller integers are visited as 64 bit integers with a range check when consuming.
+	template<typename I>
+	void visit_ranged_integer(visitor &v,I &ip) {
+		typedef typename std::conditional<std::is_signed<I>::value,int64_t,uint64_t>::type W;
+		W w = ip;
+		if (v.peek() == vt_none) {
+			v.visit(w);
+		} else {
+			v.visit(w);
+			if (w < (W)std::numeric_limits<I>::min() || w > (W)std::numeric_limits<I>::max())
+				v.error("Integer " + std::to_string(w) + " is out of range");
+			else
+				ip = (I)w;
+		}
+	}
+	template<> struct visit<uint32_t> { visit(visitor &v,uint32_t &ip) { visit_ranged_integer(v,ip); } };
+	template<> struct visit<int16_t> { visit(visitor &v,int16_t &ip) { visit_ranged_integer(v,ip); } };
+	template<> struct visit<uint16_t> { visit(visitor &v,uint16_t &ip) { visit_ranged_integer(v,ip); } };
+	template<> struct visit<int8_t> { visit(visitor &v,int8_t &ip) { visit_ranged_integer(v,ip); } };
+	template<> struct visit<uint8_t> { visit(visitor &v,uint8_t &ip) { visit_ranged_integer(v,ip); } };
+
 	template<> struct visit<bool> {
 		visit(visitor &v,bool &bp) {
 			v.visit(bp);
@@ -895,6 +1667,29 @@ namespace rpoco {
 
 	// string visitation
 	template<> struct visit<std::string> { visit(visitor &v,std::string &str) {
+		// consumed strings replace the old contents, keeping the capacity
+		if (v.peek() != vt_none)
+			str.clear();
+		v.visit(str);
+	}};
+
+	// strings with other allocators (f.ex. std::pmr::string) are read without a temporary copy
+	// when the visitor can refer to its input.
+	template<typename A> struct visit<std::basic_string<char, std::char_traits<char>, A>> {
+		visit(visitor &v, std::basic_string<char, std::char_traits<char>, A> &str) {
+			string_ref ref;
+			if (v.peek() == vt_none) {
+				ref.refer(str.data(), str.size());
+				v.visit(ref);
+			} else {
+				v.visit(ref);
+				str.assign(ref.data(), ref.size());
+			}
+		}
+	};
+
+	// string_ref visitation
+	template<> struct visit<string_ref> { visit(visitor &v,string_ref &str) {
 		v.visit(str);
 	}};
 
@@ -921,6 +1716,7 @@ namespace rpoco {
 	class type_info : public member_provider {
 		std::vector<member*> fields;
 		std::unordered_map<std::string, member*> m_named_fields;
+		key_index m_field_index;
 		std::atomic<int> m_is_init;
 		std::mutex init_mutex;
 		std::vector<std::function<void()>> post_init;
@@ -979,6 +1775,14 @@ namespace rpoco {
 		virtual member*& operator[](const std::string & id) {
 			return m_named_fields[id];
 		}
+		virtual member* find(const char *id, size_t len) {
+			int idx = m_field_index.find(id, len);
+			return idx < 0 ? nullptr : fields[idx];
+		}
+		virtual member* find(const char *id, size_t len, int &hint) {
+			int idx = m_field_index.find(id, len, hint);
+			return idx < 0 ? nullptr : fields[idx];
+		}
 		// has this type been initialized?
 		int is_init() {
 			return m_is_init.load();
@@ -988,6 +1792,10 @@ namespace rpoco {
 			std::lock_guard<std::mutex> lock(init_mutex);
 			if (!m_is_init.load()) {
 				initfun(this);
+				std::vector<std::string> names;
+				for (member *f : fields)
+					names.push_back(f->name());
+				m_field_index.build(names);
 				for (auto pcb : post_init)
 					pcb();
 				m_is_init.store(1);
@@ -1035,7 +1843,7 @@ namespace rpoco {
 		}
 		// general attribute types with no type attribute links.
 		template<typename T>
-		void set_attribute_int(rpoco::type_info *mp, const T &v,...) {
+		void set_attribute_int(rpoco::type_info * /*mp*/, const T &v,...) {
 			T* attrib = new T(v);
 			link_field_type<T>(attrib);
 			m_attributes[std::type_index(typeid(T))] = attrib;
@@ -1063,6 +1871,9 @@ namespace rpoco {
 		virtual void visit(visitor &v,void *p) {
 			rpoco::visit<F>(v,*(F*)( (uintptr_t)p+(std::ptrdiff_t)m_offset ));
 		}
+		virtual void reset(void *p) {
+			rpoco::reset(*(F*)( (uintptr_t)p+(std::ptrdiff_t)m_offset ));
+		}
 		virtual void query( std::function<void(rpoco::query&) > qt,void *p) {
 			//auto q=make_query( *(F*)( (uintptr_t)p+(std::ptrdiff_t)m_offset ) );
 			typedquery<F> q( (F*)( (uintptr_t)p+(std::ptrdiff_t)m_offset ) );
@@ -1099,7 +1910,7 @@ namespace rpoco {
 	template<typename T,typename ...ATTRS>
 	struct rpoco_type_info_expand_member<taginfo<T,ATTRS...>> {
 		template<int I, typename TAI>
-		void set_attrib(rpoco::type_info *ti, rpoco::field<typename std::remove_reference<T>::type > *fld, TAI &tai) {
+		void set_attrib(rpoco::type_info * /*ti*/, rpoco::field<typename std::remove_reference<T>::type > * /*fld*/, TAI & /*tai*/) {
 		}
 		template<int I, typename TAI, typename H, typename ...REST>
 		void set_attrib(rpoco::type_info *ti, rpoco::field<typename std::remove_reference<T>::type > *fld, TAI &tai) {
@@ -1117,7 +1928,7 @@ namespace rpoco {
 		}
 	};
 
-	static void rpoco_type_info_expand(rpoco::type_info *ti,uintptr_t _ths,std::vector<std::string>& names,int idx) {}
+	static void rpoco_type_info_expand(rpoco::type_info * /*ti*/,uintptr_t /*_ths*/,std::vector<std::string>& /*names*/,int /*idx*/) {}
 
 //	template<typename... R>
 //	void rpoco_type_info_expand(rpoco::type_info *ti, uintptr_t _ths, std::vector<std::string>& names, int idx, const char * data, const R&... rest) {
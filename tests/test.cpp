@@ -8,8 +8,23 @@
 #include <vector>
 #include <filesystem>
 #include <fstream>
+#include <variant>
+#include <memory_resource>
+#include <atomic>
 
-#include <rpoco/rpocojson.hpp>
+#include <rpoco/json.hpp>
+#include <rpoco/json_push.hpp>
+#include <rpoco/json_tape.hpp>
+#include <rpoco/json_parallel.hpp>
+#include <rpoco/json_paths.hpp>
+
+#ifndef _WIN32
+ #include <algorithm>
+ #include <iterator>
+ #include <thread>
+ #include <sys/socket.h>
+ #include <unistd.h>
+#endif
 
 
 // Note: we probably need some #ifdefs to work with other compilers than MSVC2013
@@ -35,10 +50,1039 @@
  #endif
 #endif
 
-using namespace rpocojson;
+using rpoco::json_value;
 
 bool node_diff=false;
 
+#ifndef _WIN32
+// targets the push parser fills piecewise, unknown members are skipped and the elements of the
+// vector are added one by one.
+struct push_record {
+	int id=0;
+	std::string name;
+	RPOCO(id,name);
+};
+
+// sends a file over a socketpair in small pieces and feeds the received chunks to push parsers
+// to check that they agree with the regular parser even when tokens are split between chunks.
+// The json_value is collected whole while objects and arrays of records are filled piecewise.
+bool push_matches(const std::string &filename,bool ext,bool expected,json_value *ref) {
+	std::ifstream is(filename,std::ios::binary);
+	std::string data((std::istreambuf_iterator<char>(is)),std::istreambuf_iterator<char>());
+	int fds[2];
+	if (socketpair(AF_UNIX,SOCK_STREAM,0,fds))
+		return false;
+	std::thread writer([&]() {
+		for (size_t off=0;off<data.size();off+=7)
+			send(fds[0],data.data()+off,std::min<size_t>(7,data.size()-off),0);
+		close(fds[0]);
+	});
+	json_value *jv=0;
+	push_record record,regular_record;
+	std::vector<push_record> records,regular_records;
+	bool pr,rr,vr;
+	{
+		rpoco::json::push_parser<json_value*> pp(jv,ext);
+		rpoco::json::push_parser<push_record> rp(record,ext);
+		rpoco::json::push_parser<std::vector<push_record>> vp(records,ext);
+		char buf[5];
+		ssize_t count;
+		while ((count=recv(fds[1],buf,sizeof(buf),0))>0) {
+			pp.feed(buf,count);
+			rp.feed(buf,count);
+			vp.feed(buf,count);
+		}
+		pr=pp.finish();
+		rr=rp.finish();
+		vr=vp.finish();
+	}
+	writer.join();
+	close(fds[1]);
+	bool same=pr==expected && (!pr || rpoco::to_json(jv)==rpoco::to_json(ref));
+	same=same && rr==rpoco::parse_json(data,regular_record,ext) && (!rr || rpoco::to_json(record)==rpoco::to_json(regular_record));
+	same=same && vr==rpoco::parse_json(data,regular_records,ext) && (!vr || rpoco::to_json(records)==rpoco::to_json(regular_records));
+	if (jv)
+		delete jv;
+	return same;
+}
+#endif
+
+// the push parser should fill the target as soon as the value has ended, even when it's fed a
+// byte at a time, and reject anything but spaces and comments after it.
+bool push_checks() {
+	std::string data="/* a [ \"comment\" */ {\"a\":[1,\"]}\\\"\"],\"b\":{}} // done\n ";
+	json_value *v=0;
+	bool ok=true;
+	{
+		rpoco::json::push_parser<json_value*> mp(v,true);
+		for (size_t i=0;i<data.size() && ok;i++) {
+			ok=mp.feed(data.data()+i,1);
+			// the json_value is made when the object starts and parsed at the last brace
+			if (ok && (v!=0)!=(i>=data.find("{\"a\"")))
+				ok=false;
+			if (ok && v && (v->map()->size()==2)!=(i>=data.find("} //")))
+				ok=false;
+		}
+		ok=ok && mp.finish() && rpoco::to_json(v)=="{\"a\":[1,\"]}\\\"\"],\"b\":{}}";
+	}
+	delete v;
+	v=0;
+	rpoco::json::push_parser<json_value*> garbage(v);
+	if (!ok || !garbage.feed("[1] ") || garbage.feed("[2]") || garbage.finish())
+		return false;
+	delete v;
+	v=0;
+	// line comments end at a carriage return as well, the brace after it ends the value
+	rpoco::json::push_parser<json_value*> cr(v,true);
+	if (!cr.feed("{\"a\":1 // x\r}") || !v || !cr.finish())
+		return false;
+	delete v;
+	v=0;
+	int number=0;
+	rpoco::json::push_parser<int> scalar(number),open(number,true);
+	return scalar.feed("4") && scalar.feed("2") && scalar.finish() && number==42 &&
+		open.feed("7 /* ") && !open.finish();
+}
+
+// strings must hold valid UTF-8, whether it's copied from the input in bulk, a byte at a time from a
+// stream or decoded from escapes.
+bool utf8_checks() {
+	const char *valid[][2]={
+		{"\xC2\xA9","\xC2\xA9"},{"\xE2\x82\xAC","\xE2\x82\xAC"},{"\xF0\x9F\x98\x80","\xF0\x9F\x98\x80"},{"\xF4\x8F\xBF\xBF","\xF4\x8F\xBF\xBF"},
+		{"\\u00e9","\xC3\xA9"},{"\\uD83D\\uDE00","\xF0\x9F\x98\x80"},{"\\uDBFF\\uDFFF","\xF4\x8F\xBF\xBF"}};
+	const char *invalid[]={
+		"\xC0\xAF","\xC1\xBF","\xE0\x80\xAF","\xF0\x80\x80\xAF", // overlong
+		"\xED\xA0\x80","\xED\xBF\xBF", // encoded surrogates
+		"\xF4\x90\x80\x80","\xF5\x80\x80\x80","\xFF", // above U+10FFFF
+		"\xE2\x82","\xF0\x9F\x98","\xC2", // truncated
+		"\x80","a\xBF","\xE2\x82\xAC\x80", // stray continuation bytes
+		"\\uDC00","\\uD800","\\uD800\\u0041","\\uD800x"}; // lone surrogate escapes
+	for (int pad=0;pad<70;pad+=69) {
+		std::string prefix(pad,'a');
+		for (auto &v:valid) {
+			std::string doc="\""+prefix+v[0]+"\"",s;
+			rpoco::string_ref r;
+			std::istringstream is(doc);
+			if (!rpoco::parse_json(doc,s) || s!=prefix+v[1] || !rpoco::parse_json(doc,r) || r.str()!=prefix+v[1] || !rpoco::parse_json(is,s) || s!=prefix+v[1])
+				return false;
+		}
+		for (const char *bad:invalid) {
+			std::string doc="\""+prefix+bad+"\"",s;
+			rpoco::string_ref r;
+			std::istringstream is(doc);
+			if (rpoco::parse_json(doc,s) || rpoco::parse_json(doc,r) || rpoco::parse_json(is,s))
+				return false;
+		}
+	}
+	return true;
+}
+
+// the vector kernels must agree with the scalar code, both on blocks of tricky bytes and on whole
+// documents where quotes and backslashes land around the 64 byte block boundary.
+struct boundary_record {
+	int id=0;
+	std::string name;
+	RPOCO(id,name);
+};
+
+bool simd_checks() {
+	const char bytes[]={'"','\\',' ','\t','\n','\r','{','}','[',']',':',',','a','0','{'|0x20,'['^0x20,(char)0x80,(char)0xff,0x1f,0x7f,0};
+	uint32_t seed=12345;
+	char block[64+32];
+	for (int n=0;n<20000;n++) {
+		for (char &c:block) {
+			seed=seed*1103515245+12345;
+			c=bytes[(seed>>16)%sizeof(bytes)];
+		}
+		rpoco::json::scan::block a=rpoco::json::scan::classify(block),b=rpoco::json::scan::classify_scalar(block);
+		if (a.space!=b.space || a.op!=b.op || a.quote!=b.quote || a.backslash!=b.backslash)
+			return false;
+		size_t len=(seed>>8)%sizeof(block),run=0;
+		while (run<len && block[run]!='"' && block[run]!='\\' && (unsigned char)block[run]>=0x20 && (unsigned char)block[run]<0x80)
+			run++;
+		if (rpoco::json::scan::plain_run(block,len)!=run)
+			return false;
+	}
+	// buffers take the block paths while streams are read a character at a time
+	const char *tails[]={"\\\"","\\\\","\\\\\\\"","\\\\\\\\\\\\","\\u0041\\\"","\\n\\\"\\\\"};
+	for (int pad=50;pad<80;pad++) {
+		for (const char *tail:tails) {
+			std::string str="\"" + std::string(pad,'a') + tail + "\"";
+			std::string doc="{\"unknown\":[" + str + ",{\"k\":" + str + "}],\"name\":" + str + ",\"id\":3}";
+			boundary_record buffered,streamed;
+			std::istringstream is(doc);
+			if (!rpoco::parse_json(doc,buffered) || !rpoco::parse_json(is,streamed) || buffered.name!=streamed.name || buffered.id!=3 || streamed.id!=3)
+				return false;
+			rpoco::json::value v;
+			if (!rpoco::parse_json(doc,v) || rpoco::to_json(v["name"])!=rpoco::to_json(buffered.name))
+				return false;
+			// an unterminated string must fail the same way on both paths
+			std::string cut=doc.substr(0,pad+14);
+			std::istringstream cs(cut);
+			if (rpoco::parse_json(cut,buffered) || rpoco::parse_json(cs,streamed))
+				return false;
+		}
+	}
+	return true;
+}
+
+// integer fields of all sizes should round trip their extremes and reject values out of their range.
+struct integers {
+	int64_t i64=0;
+	uint64_t u64=0;
+	uint32_t u32=0;
+	int16_t i16=0;
+	uint8_t u8=0;
+	RPOCO(i64,u64,u32,i16,u8);
+};
+
+bool integer_checks() {
+	std::string extremes="{\"i64\":-9223372036854775808,\"u64\":18446744073709551615,\"u32\":4294967295,\"i16\":-32768,\"u8\":255}";
+	integers in;
+	if (!rpoco::parse_json(extremes,in) || rpoco::to_json(in)!=extremes)
+		return false;
+	const char *overflows[]={
+		"{\"i64\":9223372036854775808}",
+		"{\"u64\":18446744073709551616}",
+		"{\"u64\":-1}",
+		"{\"u32\":4294967296}",
+		"{\"i16\":-32769}",
+		"{\"u8\":256}",
+		"{\"u8\":1.5}",
+	};
+	for (const char *overflow:overflows) {
+		integers out;
+		if (rpoco::parse_json(std::string(overflow),out)) {
+			printf("Error, %s was parsed\n",overflow);
+			return false;
+		}
+	}
+	return true;
+}
+
+// the perfect hash should find every name it was built from and nothing else, including keys that
+// land on a taken slot, and aliased names should replace the field names.
+struct aliased {
+	int id=0;
+	int name=0;
+	int8_t small=0;
+	uint16_t port=0;
+	RPOCO(_(id,rpoco::json::alias("ID")),_(name,rpoco::json::alias("title")),small,port);
+};
+
+bool key_checks() {
+	for (int n:{1,2,3,5,17,64,200}) {
+		std::vector<std::string> names;
+		for (int i=0;i<n;i++)
+			names.push_back(i%3 ? "field_"+std::to_string(i) : std::string(i/3+1,'k'));
+		rpoco::key_index index;
+		index.build(names);
+		for (int i=0;i<n;i++)
+			if (index.find(names[i].data(),names[i].size())!=i)
+				return false;
+		// the table is up to half full so many of these probe a slot that holds another name
+		for (int i=0;i<2000;i++) {
+			std::string miss=i%2 ? "field_"+std::to_string(i+n) : "Field_"+std::to_string(i%n);
+			if (index.find(miss.data(),miss.size())>=0)
+				return false;
+		}
+		for (const char *miss:{"","f","field_","k "})
+			if (index.find(miss,strlen(miss))>=0 || index.find("field_1",8)>=0)
+				return false;
+	}
+	// the last of repeated names wins, also when hinted at the first
+	rpoco::key_index repeated;
+	repeated.build({"a","b","a"});
+	int hint=0;
+	if (repeated.find("a",1)!=2 || repeated.find("b",1)!=1 || repeated.find("a",1,hint)!=2 || hint!=3)
+		return false;
+	rpoco::key_index empty;
+	empty.build({});
+	if (empty.find("a",1)>=0)
+		return false;
+	aliased a;
+	if (!rpoco::parse_json(std::string("{\"ID\":1,\"title\":2,\"id\":3,\"name\":4,\"small\":-128,\"port\":65535}"),a) || a.id!=1 || a.name!=2 || a.small!=-128 || a.port!=65535)
+		return false;
+	if (rpoco::to_json(a)!="{\"ID\":1,\"title\":2,\"small\":-128,\"port\":65535}")
+		return false;
+	// the narrow integer types take their whole range and nothing outside it
+	const char *outside[]={"{\"small\":128}","{\"small\":-129}","{\"port\":65536}","{\"port\":-1}"};
+	for (const char *o:outside)
+		if (rpoco::parse_json(std::string(o),a))
+			return false;
+	return rpoco::parse_json(std::string("{\"small\":127,\"port\":0}"),a) && a.small==127 && a.port==0;
+}
+
+// members are matched with a guess at the next declared one first, the result must not depend on the
+// order the members arrive in or on unknown members between them.
+struct ordered {
+	int a=0;
+	std::string b;
+	double c=0;
+	bool d=false;
+	std::vector<int> e;
+	RPOCO(a,b,c,d,e);
+};
+struct ordered_aliased {
+	int a=0;
+	std::string b;
+	double c=0;
+	bool d=false;
+	std::vector<int> e;
+	RPOCO(_(a,rpoco::json::alias("A")),b,c,_(d,rpoco::json::alias("D")),e);
+};
+
+template<typename T>
+bool same_in_any_order(const std::vector<std::string> &members,const std::string &expected) {
+	std::vector<size_t> order;
+	for (size_t i=0;i<members.size();i++)
+		order.push_back(i);
+	int permutation=0;
+	do {
+		for (int unknowns=0;unknowns<3;unknowns++) {
+			std::string data="{";
+			for (size_t i=0;i<order.size();i++) {
+				if (unknowns && (i+permutation)%(unknowns+1)==0)
+					data+="\"x"+std::to_string(i)+"\":{\"a\":1},";
+				data+=members[order[i]]+(i+1<order.size()?",":"");
+			}
+			if (unknowns==2)
+				data+=",\"zz\":[1]";
+			data+="}";
+			T t;
+			if (!rpoco::parse_json(data,t) || rpoco::to_json(t)!=expected) {
+				printf("Error, %s parsed to %s\n",data.c_str(),rpoco::to_json(t).c_str());
+				return false;
+			}
+		}
+		permutation++;
+	} while (std::next_permutation(order.begin(),order.end()));
+	return true;
+}
+
+bool order_checks() {
+	return same_in_any_order<ordered>({"\"a\":1","\"b\":\"x\"","\"c\":2.5","\"d\":true","\"e\":[3]"},"{\"a\":1,\"b\":\"x\",\"c\":2.5,\"d\":true,\"e\":[3]}") &&
+		same_in_any_order<ordered_aliased>({"\"A\":1","\"b\":\"x\"","\"c\":2.5","\"D\":true","\"e\":[3]","\"a\":7","\"d\":false"},"{\"A\":1,\"b\":\"x\",\"c\":2.5,\"D\":true,\"e\":[3]}");
+}
+
+// string_ref fields should point into the parsed buffer unless the string had escapes to decode.
+struct route {
+	rpoco::string_ref path;
+	rpoco::string_ref method;
+	RPOCO(path,method);
+};
+
+bool string_ref_checks() {
+	std::string data="{\"path\":\"/users/1\",\"method\":\"G\\u0045T\"}";
+	route r;
+	if (!rpoco::parse_json(data,r))
+		return false;
+	bool path_ok=!r.path.owned() && r.path.data()==data.data()+9 && r.path.str()=="/users/1";
+	bool method_ok=r.method.owned() && r.method.str()=="GET";
+	return path_ok && method_ok && rpoco::to_json(r)=="{\"path\":\"/users/1\",\"method\":\"GET\"}";
+}
+
+// polymorphic objects are built from the type selected by their "kind" member, wherever it appears in the object.
+struct shape {
+	const char *kind="shape";
+	int id=0;
+	virtual ~shape() {}
+	RPOCO(kind,id);
+};
+struct circle : shape {
+	double r=0;
+	circle() { kind="circle"; }
+	RPOCO(kind,id,r);
+};
+struct rect : shape {
+	double w=0,h=0;
+	rect() { kind="rect"; }
+	RPOCO(kind,id,w,h);
+};
+struct drawing {
+	std::vector<shape*> shapes;
+	std::vector<std::variant<circle,rect,std::string>> items;
+	RPOCO(_(shapes,rpoco::json::select<circle,rect>("kind")),_(items,rpoco::json::select<circle,rect>("kind")));
+	~drawing() {
+		for (shape *s:shapes)
+			delete s;
+	}
+};
+
+// a stream buffer that can't seek, like a pipe or socket
+struct unseekable_buf : std::streambuf {
+	std::string data;
+	unseekable_buf(const std::string &d) : data(d) {
+		setg(&data[0],&data[0],&data[0]+data.size());
+	}
+};
+
+bool select_checks() {
+	std::string data="{\"shapes\":[{\"id\":1,\"r\":2.5,\"kind\":\"circle\"},{\"kind\":\"rect\",\"w\":3,\"h\":4}],"
+		"\"items\":[{\"w\":5,\"kind\":\"rect\",\"h\":6},\"text\",{\"kind\":\"circle\",\"r\":1}]}";
+	for (int i=0;i<2;i++) {
+		drawing d;
+		unseekable_buf buf(data);
+		std::istream is(&buf);
+		if (!(i==0 ? rpoco::parse_json(data,d) : rpoco::parse_json(is,d)))
+			return false;
+		circle *c=dynamic_cast<circle*>(d.shapes.size()==2 ? d.shapes[0] : nullptr);
+		rect *r=dynamic_cast<rect*>(d.shapes.size()==2 ? d.shapes[1] : nullptr);
+		if (!c || c->id!=1 || c->r!=2.5 || !r || r->w!=3 || r->h!=4)
+			return false;
+		if (d.items.size()!=3 || std::get<rect>(d.items[0]).h!=6 || std::get<std::string>(d.items[1])!="text" || std::get<circle>(d.items[2]).r!=1)
+			return false;
+	}
+	return true;
+}
+
+// large uploads should be filled as they arrive with only the token being read kept between chunks,
+// values for targets that can't be filled piecewise are kept until they end.
+struct push_item {
+	int id=0;
+	std::vector<double> values;
+	RPOCO(id,values);
+};
+struct push_upload {
+	std::string name;
+	std::vector<push_item> items;
+	json_value meta;
+	RPOCO(name,items,meta);
+};
+
+bool push_fill_checks() {
+	std::string data="{\"name\":\"up\\u006coad\",\"unknown\":{\"x\":[1,{\"y\":\"\\u0041\"}]},\"items\":[";
+	for (int i=0;i<2000;i++)
+		data+=(i ? ",{\"id\":" : "{\"id\":")+std::to_string(i)+",\"values\":[0.5,"+std::to_string(i)+"e-1]}";
+	data+="],\"meta\":{\"k\":[1,\"v\"]}}";
+	push_upload upload,regular;
+	rpoco::json::push_parser<push_upload> pp(upload);
+	size_t most=0;
+	bool halfway=false;
+	for (size_t off=0;off<data.size();off+=13) {
+		if (!pp.feed(data.data()+off,std::min<size_t>(13,data.size()-off)))
+			return false;
+		if (data.find("\"meta\"")>off)
+			most=std::max(most,pp.pending());
+		// the items so far are there before the message has ended
+		if (!halfway && off>=data.size()/2) {
+			halfway=true;
+			if (upload.name!="upload" || upload.items.size()<900 || upload.items[899].id!=899)
+				return false;
+		}
+	}
+	if (!pp.finish() || most>16 || !rpoco::parse_json(data,regular) || rpoco::to_json(upload)!=rpoco::to_json(regular))
+		return false;
+	// selected types are picked by members that can come last so those objects are kept until they end
+	std::string shapes="{\"shapes\":[{\"id\":1,\"r\":2,\"kind\":\"circle\"},{\"kind\":\"rect\",\"w\":3,\"h\":4}],\"items\":[\"text\",{\"h\":5,\"kind\":\"rect\"}]}";
+	drawing pushed,parsed;
+	rpoco::json::push_parser<drawing> dp(pushed);
+	bool ok=true;
+	for (size_t i=0;i<shapes.size();i++)
+		ok=ok && dp.feed(shapes.data()+i,1);
+	return ok && dp.finish() && rpoco::parse_json(shapes,parsed) && rpoco::to_json(pushed)==rpoco::to_json(parsed) &&
+		pushed.shapes.size()==2 && dynamic_cast<rect*>(pushed.shapes[1]);
+}
+
+// json::value keeps short strings inline and objects as flat arrays sorted by key where later duplicates win.
+bool value_checks() {
+	std::string data="{\"z\":1,\"a\":\"a string that doesn't fit inline\",\"m\":[true,null,\"short\"],\"z\":2}";
+	json_value jv;
+	if (!rpoco::parse_json(data,jv) || jv.map()->size()!=3 || int(jv["z"])!=2 || jv["m"][2].to_string()!="short")
+		return false;
+	jv["b"]=std::string("inserted");
+	json_value copy=jv;
+	copy=copy["m"];
+	if (copy.array()->size()!=3 || !copy[0].to_bool())
+		return false;
+	if (rpoco::to_json(jv)!="{\"a\":\"a string that doesn't fit inline\",\"b\":\"inserted\",\"m\":[true,null,\"short\"],\"z\":2}")
+		return false;
+	// large objects built key by key are hashed, written in key order and only sorted by sort()
+	json_value large;
+	std::string expected="{";
+	for (int i=999;i>=0;i--) {
+		large.emplace("k"+std::to_string(i),(double)i);
+		if (int(large["k"+std::to_string(i)])!=i || int(large["k999"])!=999 || large.has("k"+std::to_string(i-1)))
+			return false;
+	}
+	std::vector<std::string> keys;
+	for (int i=0;i<1000;i++)
+		keys.push_back("k"+std::to_string(i));
+	std::sort(keys.begin(),keys.end());
+	for (auto &k:keys)
+		expected+=(expected.size()>1?",\"":"\"")+k+"\":"+k.substr(1);
+	expected+="}";
+	json_value reparsed,copied=large;
+	if (large.map()->size()!=1000 || rpoco::to_json(large)!=expected || rpoco::to_json(copied)!=expected)
+		return false;
+	if (!rpoco::parse_json(expected,reparsed) || int(reparsed["k500"])!=500 || reparsed.has("k1000"))
+		return false;
+	reparsed["k1000"]=1000.0;
+	// iterating doesn't move members so references taken before stay valid
+	json_value *k5=reparsed.map()->find("k5");
+	size_t members=0,found=0;
+	for (const rpoco::json::entry &e:*(const rpoco::json::object*)reparsed.map()) {
+		members++;
+		found+=&e.val==k5;
+	}
+	if (members!=1001 || found!=1 || reparsed.map()->find("k5")!=k5 || reparsed.map()->begin()[1000].key.to_string()!="k1000")
+		return false;
+	reparsed.map()->sort();
+	if (int(reparsed["k1000"])!=1000 || reparsed.map()->begin()[4].key.to_string()!="k1000" || reparsed.map()->size()!=1001)
+		return false;
+	// values are built in place and moved without copying the subtrees
+	static_assert(std::is_nothrow_move_constructible<json_value>::value,"json::value moves should be noexcept");
+	json_value built;
+	built.emplace("list").emplace_back(1);
+	built["list"].emplace_back("two");
+	built.emplace("flag",true);
+	json_value moved(std::move(built));
+	std::vector<json_value> many(3,moved);
+	many.emplace_back(std::move(moved));
+	return built.type()==rpoco::vt_null && moved.type()==rpoco::vt_null && rpoco::to_json(many.back())=="{\"flag\":true,\"list\":[1,\"two\"]}";
+}
+
+// lazily parsed values should only parse the objects and arrays that are accessed.
+bool lazy_checks() {
+	std::string data="{\"body\":{\"big\":[1,2,3,{\"x\":\"]}\"}]},\"head\":{\"id\":7,\"tags\":[\"a\",\"b\"]}}";
+	json_value jv;
+	if (!rpoco::parse_json_lazy(data.data(),data.size(),jv) || !jv.lazy() || jv.type()!=rpoco::vt_object)
+		return false;
+	json_value &head=jv["head"];
+	if (jv.lazy() || !head.lazy() || !jv["body"].lazy())
+		return false;
+	if (int(head["id"])!=7 || head["tags"][1].to_string()!="b" || !jv["body"].lazy())
+		return false;
+	json_value copy=jv;
+	if (rpoco::to_json(copy)!=data || rpoco::to_json(jv)!=data)
+		return false;
+	// errors in the unparsed parts fail the parse
+	for (const char *bad:{"{\"a\":{\"b\":tru}}","{\"a\":[1,2}}","{\"a\":{\"b\":\"\\q\"}}","{\"a\":{/* c */}}"})
+		if (rpoco::parse_json_lazy(bad,strlen(bad),jv))
+			return false;
+	// and the options are kept for when they're parsed
+	std::string commented="{\"a\":{/* c */\"b\":[1 // d\n]}}";
+	if (!rpoco::parse_json_lazy(commented.data(),commented.size(),jv,true) || !jv["a"].lazy() || int(jv["a"]["b"][0])!=1)
+		return false;
+	std::string pair="{\"a\":{\"s\":\"\\uD83D\\uDE00\"}}";
+	if (!rpoco::parse_json_lazy(pair.data(),pair.size(),jv,false,false) || jv["a"]["s"].to_string()!="\xED\xA0\xBD\xED\xB8\x80")
+		return false;
+	if (!rpoco::parse_json_lazy(pair.data(),pair.size(),jv) || jv["a"]["s"].to_string()!="\xF0\x9F\x98\x80")
+		return false;
+	// text set directly is validated up front
+	json_value direct;
+	std::string text=" [1,{\"x\":[]}] ";
+	if (direct.set_lazy(rpoco::vt_array,"[1,",3) || direct.type()!=rpoco::vt_null || direct.set_lazy(rpoco::vt_object,text.data(),text.size()))
+		return false;
+	return direct.set_lazy(rpoco::vt_array,text.data(),text.size()) && direct.lazy() && rpoco::to_json(direct)=="[1,{\"x\":[]}]";
+}
+
+// tapes should keep the document in order and find members and elements from the tape.
+bool tape_checks() {
+	std::string data="{\"name\":\"rpoco\",\"n\":[1,2.5,{\"x\":true}],\"e\":{},\"a\":[],\"s\":\"q\\\"\",\"z\":null}";
+	rpoco::json::tape t;
+	if (!rpoco::parse_json(data,t) || rpoco::to_json(t)!=data)
+		return false;
+	rpoco::json::tape::node root=t.root();
+	if (root.size()!=6 || root["name"].to_string()!="rpoco" || root["n"][1].to_number()!=2.5 || !root["n"][2]["x"].to_bool())
+		return false;
+	if (root.has("missing") || !root["z"].is_null() || root["n"][3].type()!=rpoco::vt_null || root["e"].type()!=rpoco::vt_object)
+		return false;
+	std::string keys;
+	for (auto it=root.begin();it!=root.end();++it)
+		keys.append(it.key(),it.key_length());
+	if (keys!="nameneasz")
+		return false;
+	// integers above 2^53 don't survive a double so they're kept as integers
+	std::string ids="{\"id\":12345678901234567890,\"n\":9007199254740993,\"neg\":-9007199254740993,\"f\":1.5}";
+	rpoco::json::tape big;
+	if (!rpoco::parse_json(ids,big) || rpoco::to_json(big)!=ids)
+		return false;
+	rpoco::json::tape::node nums=big.root();
+	if (nums["id"].to_uint64()!=12345678901234567890ULL || nums["n"].to_int64()!=9007199254740993LL || nums["neg"].to_int64()!=-9007199254740993LL)
+		return false;
+	return nums["id"].type()==rpoco::vt_number && nums["id"].to_int64()==0 && nums["neg"].to_uint64()==0 && nums["f"].to_int64()==1 && nums["f"].to_number()==1.5;
+}
+
+// parsing into an arena should place pmr containers and json::value data in it but keep pointer targets deletable.
+struct owner_info {
+	std::pmr::string name;
+	int level=0;
+	RPOCO(name,level);
+};
+struct document {
+	owner_info *owner=nullptr;
+	std::pmr::vector<std::pmr::string> tags;
+	json_value meta;
+	RPOCO(owner,tags,meta);
+	document(std::pmr::memory_resource *memory) : tags(memory) {}
+	~document() { delete owner; }
+};
+
+bool arena_checks() {
+	std::string data="{\"owner\":{\"name\":\"a long enough owner name\",\"level\":3},\"tags\":[\"first tag that is long\",\"b\"],\"meta\":{\"k\":[1,\"v\"]}}";
+	rpoco::arena arena(1024);
+	for (int i=0;i<3;i++) {
+		document doc(&arena);
+		if (!rpoco::parse_json(arena,data,doc) || rpoco::to_json(doc)!=data)
+			return false;
+		// the owner is deleted by the document so it must not come from the arena
+		if (!doc.owner || doc.tags.size()!=2 || doc.tags[0].get_allocator().resource()!=&arena)
+			return false;
+		doc.meta.set_null();
+		arena.reset();
+	}
+	return true;
+}
+
+// json lines parsed on several threads should come out in input order with their line numbers.
+struct line_record {
+	int id=0;
+	std::string name;
+	RPOCO(id,name);
+};
+
+bool line_checks() {
+	std::string data;
+	for (int i=0;i<20000;i++) {
+		data+="{\"id\":"+std::to_string(i)+",\"name\":\"record "+std::to_string(i)+"\"}\n";
+		if (i==100)
+			data+="  \n";
+	}
+	std::vector<line_record> records;
+	if (!rpoco::json::parse_lines(data,records,4) || records.size()!=20000)
+		return false;
+	for (int i=0;i<20000;i++)
+		if (records[i].id!=i || records[i].name!="record "+std::to_string(i))
+			return false;
+	// an executor runs the pieces instead of new threads
+	unsigned executed=0;
+	rpoco::json::executor serial=[&executed](unsigned count,const std::function<void(unsigned)> &run) {
+		for (unsigned i=0;i<count;i++,executed++)
+			run(i);
+	};
+	std::vector<line_record> serial_records;
+	if (!rpoco::json::parse_lines(data,serial_records,4,false,true,serial) || executed!=4 || rpoco::to_json(serial_records)!=rpoco::to_json(records))
+		return false;
+	// line numbers count the blank line, bad lines fail the parse but the rest are kept
+	std::atomic<int> mismatches(0);
+	std::atomic<int> count(0);
+	data+="{\"id\":\n{\"id\":20001,\"name\":\"last\"}";
+	bool ok=rpoco::json::parse_lines<line_record>(data.data(),data.size(),[&](size_t line,line_record &r) {
+		if (line!=(size_t)r.id+(r.id>100?2:1))
+			mismatches++;
+		count++;
+	},4);
+	return !ok && !mismatches && count==20001;
+}
+
+// the elements of a big array parsed on several threads should match a regular parse.
+bool array_checks() {
+	std::string data="[";
+	for (int i=0;i<20000;i++)
+		data+=std::string(i?", ":"")+"{\"name\":\"record [" + std::to_string(i)+"]\",\"id\":"+std::to_string(i)+"}";
+	data+="]";
+	std::vector<line_record> records,expected;
+	if (!rpoco::json::parse_array(data,records,4) || !rpoco::parse_json(data,expected))
+		return false;
+	if (rpoco::to_json(records)!=rpoco::to_json(expected) || records.size()!=20000 || records[19999].id!=19999)
+		return false;
+	std::vector<line_record> none;
+	if (!rpoco::json::parse_array(" [ ] ",none,4) || none.size())
+		return false;
+	// a failed parse leaves the vector as it was
+	char middle=data[data.size()/2];
+	data[data.size()/2]=0;
+	none.resize(2);
+	none[1].id=7;
+	if (rpoco::json::parse_array(data,none,4) || none.size()!=2 || none[1].id!=7)
+		return false;
+	data[data.size()/2]=middle;
+	size_t bad=data.find("\"id\":10000}");
+	data.replace(bad,11,"\"id\":\"10000\"}");
+	if (rpoco::json::parse_array(data,none,4) || none.size()!=2 || rpoco::json::parse_array("{}",none))
+		return false;
+	// empty elements are rejected before anything is allocated for them
+	size_t capacity=none.capacity();
+	return !rpoco::json::parse_array("[1,,2]",none,4) && !rpoco::json::parse_array("[{\"id\":1},]",none,4) &&
+		!rpoco::json::parse_array("["+std::string(1<<20,',')+"]",none,4) && none.size()==2 && none.capacity()==capacity;
+}
+
+// unknown fields of all kinds and sizes are skipped over without disturbing the known ones.
+bool skip_checks() {
+	std::string big="[";
+	for (int i=0;i<50;i++)
+		big+="{\"s\":\"a string with \\\"escaped quotes\\\" and [brackets} in it "+std::to_string(i)+"\\\\\",\"n\":[1,2.5,-3e2,true,null,{}]},";
+	big+="\"]]]\"]";
+	std::string data="{\"skipped\":"+big+",\"id\":7,\"more\":{\"x\":"+big+"},\"name\":\"kept\",\"last\":\""+std::string(100,'x')+"\"}";
+	line_record r;
+	if (!rpoco::parse_json(data,r) || r.id!=7 || r.name!="kept")
+		return false;
+	// the same from a stream where nothing is buffered
+	std::istringstream is(data);
+	line_record rs;
+	if (!rpoco::parse_json(is,rs) || rs.id!=7 || rs.name!="kept")
+		return false;
+	line_record bad;
+	if (rpoco::parse_json("{\"x\":}",bad) || rpoco::parse_json("{\"x\":"+big.substr(0,big.size()-1),bad))
+		return false;
+	// skipped values are validated as strictly as parsed ones
+	const char *invalid[]={"tXYZ","[1,2}","{]","[}","{\"a\":1]","{\"a\" 1}","{\"a\":1,}","[1,]","[1 2]","{1:2}","{\"a\"}","truee","nul","fals",
+		"01","1.","-","1e","+1",".5","\"\\q\"","\"\\u12\"","\"\\uDC00\"","\"\xC0\xAF\"","\"tab\there\"","[\"a\",{\"b\":[1,{\"c\":nulL}]}]","[[[]]","[]]"};
+	for (const char *v:invalid) {
+		std::string doc=std::string("{\"id\":1,\"x\":")+v+",\"name\":\"n\"}";
+		std::istringstream is(doc);
+		if (rpoco::parse_json(doc,bad) || rpoco::parse_json(is,bad) || rpoco::parse_json(doc,bad,true)) {
+			printf("Error, %s was skipped\n",doc.c_str());
+			return false;
+		}
+	}
+	// and still accepted with comments between the tokens when they're allowed
+	std::string commented="{\"x\":/* a */[1 /* b */,{\"a\"/**/:// c\n true}],\"id\":4}";
+	return rpoco::parse_json(commented,bad,true) && bad.id==4 && !rpoco::parse_json(commented,bad);
+}
+
+// parsing into the same object again should overwrite its vectors in place and keep their storage.
+struct reused_message {
+	std::vector<line_record> records;
+	line_record *first=nullptr;
+	RPOCO(records,first);
+	~reused_message() {
+		delete first;
+	}
+};
+
+struct selected_message {
+	shape *one=nullptr;
+	std::vector<shape*> many;
+	RPOCO(_(one,rpoco::json::select<circle,rect>("kind")),_(many,rpoco::json::select<circle,rect>("kind")));
+	~selected_message() {
+		delete one;
+		for (shape *s:many)
+			delete s;
+	}
+};
+
+bool reuse_checks() {
+	std::string big="{\"records\":[{\"id\":1,\"name\":\"a name longer than the small string buffer\"},{\"id\":2,\"name\":\"b\"},{\"id\":3,\"name\":\"c\"}],\"first\":{\"id\":1,\"name\":\"a name longer than the small string buffer\"}}";
+	std::string small="{\"records\":[{\"id\":4,\"name\":\"another name\"}],\"first\":{\"id\":4,\"name\":\"another name\"}}";
+	reused_message m;
+	if (!rpoco::parse_json_reuse(big,m) || m.records.size()!=3)
+		return false;
+	const line_record *elements=m.records.data();
+	const char *name=m.records[0].name.data();
+	const line_record *first=m.first;
+	for (int i=0;i<3;i++) {
+		if (!rpoco::parse_json_reuse(small,m) || rpoco::to_json(m)!=small)
+			return false;
+		if (!rpoco::parse_json_reuse(big,m) || rpoco::to_json(m)!=big)
+			return false;
+	}
+	if (m.records.data()!=elements || m.records[0].name.data()!=name || m.first!=first)
+		return false;
+	// regular parses still append
+	if (!rpoco::parse_json(small,m) || m.records.size()!=4)
+		return false;
+	// what the input leaves out is reset like in a fresh object and a null releases a target
+	if (!rpoco::parse_json_reuse("{\"records\":[{\"id\":2,\"name\":\"x\"}],\"first\":{\"id\":2}}",m) || !rpoco::parse_json_reuse("{\"records\":[{\"id\":3}],\"first\":null}",m))
+		return false;
+	if (m.records.size()!=1 || m.records[0].id!=3 || !m.records[0].name.empty() || m.first)
+		return false;
+	if (!rpoco::parse_json_reuse("{\"first\":{\"id\":5,\"name\":\"y\"}}",m) || !m.records.empty() || !m.first || m.first->name!="y")
+		return false;
+	if (!rpoco::parse_json_reuse("{\"records\":[]}",m) || m.first)
+		return false;
+	// selected targets are visited as their own type and replaced when another type is selected
+	selected_message s;
+	if (!rpoco::parse_json_reuse("{\"one\":{\"kind\":\"circle\",\"r\":1},\"many\":[{\"kind\":\"circle\",\"r\":1}]}",s))
+		return false;
+	shape *one=s.one,*element=s.many[0];
+	if (!rpoco::parse_json_reuse("{\"one\":{\"kind\":\"circle\",\"r\":2},\"many\":[{\"kind\":\"circle\",\"r\":2}]}",s))
+		return false;
+	circle *c1=dynamic_cast<circle*>(s.one),*c2=dynamic_cast<circle*>(s.many[0]);
+	if (s.one!=one || s.many[0]!=element || !c1 || c1->r!=2 || !c2 || c2->r!=2)
+		return false;
+	if (!rpoco::parse_json_reuse("{\"one\":{\"kind\":\"rect\",\"w\":3},\"many\":[{\"w\":4,\"kind\":\"rect\"}]}",s))
+		return false;
+	rect *r1=dynamic_cast<rect*>(s.one),*r2=dynamic_cast<rect*>(s.many[0]);
+	return r1 && r1->w==3 && r2 && r2->w==4;
+}
+
+struct padded_record {
+	int id=0;
+	char pad[4096];
+	RPOCO(id);
+};
+
+// arrays are counted ahead so that vectors are allocated once.
+bool hint_checks() {
+	const char *arrays[]={"[]","[ ]","[1]","[1,2,3]","[\"a,b\",[1,2],{\"x\":[3,4],\"y\":\"]\"},\"\\\",\"]"," [ 1 , 2 ] "};
+	size_t counts[]={0,0,1,3,4,2};
+	for (int i=0;i<6;i++) {
+		const char *p=arrays[i];
+		while (*p==' ')
+			p++;
+		if (rpoco::json::scan::count_elements(p,strlen(p))!=counts[i])
+			return false;
+	}
+	// unterminated arrays and arrays with empty elements give no hint
+	const char *broken[]={"[1,2","[,]","[ ,1]","[1,,2]","[1, ,2]","[1,2 , ]"};
+	for (const char *b:broken) {
+		if (rpoco::json::scan::count_elements(b,strlen(b)))
+			return false;
+	}
+	// so a run of commas can't make a vector of large structs reserve memory
+	std::vector<padded_record> padded;
+	if (rpoco::parse_json("["+std::string(1<<20,',')+"]",padded) || padded.capacity()>1)
+		return false;
+	std::string data="[";
+	for (int i=0;i<1000;i++)
+		data+=std::string(i?",":"")+"[\"element, "+std::to_string(i)+"\",{\"a\":[1,2]}]";
+	data+="]";
+	std::vector<json_value> values;
+	return rpoco::parse_json(data,values) && values.size()==1000 && values.capacity()==1000;
+}
+
+// numbers must round correctly on the fast paths and the fallbacks past them, the expected bit
+// patterns are the correctly rounded (round half to even) results.
+template<typename N,typename B>
+bool rounds_to(const char *text,B bits) {
+	for (int negative=0;negative<2;negative++) {
+		std::string number=(negative?"-":"")+std::string(text);
+		B expected=bits|(negative?(B)1<<(sizeof(B)*8-1):0),single,bulk;
+		N n;
+		std::vector<N> ns;
+		if (!rpoco::parse_json(number,n) || !rpoco::parse_json("[0,"+number+"]",ns) || ns.size()!=2)
+			return false;
+		memcpy(&single,&n,sizeof(B));
+		memcpy(&bulk,&ns[1],sizeof(B));
+		if (single!=expected || bulk!=expected) {
+			printf("%s parsed to %llx and %llx instead of %llx\n",number.c_str(),(unsigned long long)single,(unsigned long long)bulk,(unsigned long long)expected);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool rounding_checks() {
+	struct { const char *text; uint64_t bits; } doubles[]={
+		{"0.1",0x3FB999999999999AULL},
+		{"9007199254740993",0x4340000000000000ULL}, // 2^53+1, halfway rounding down to even
+		{"9007199254740995",0x4340000000000002ULL}, // halfway rounding up to even
+		{"1e23",0x44B52D02C7E14AF6ULL},
+		{"1448997445238699",0x4314976C0803FEACULL},
+		{"3.0540412e5",0x4112A3F07AE147AEULL},
+		{"4.9e-324",0x0000000000000001ULL}, // smallest subnormal
+		{"5e-324",0x0000000000000001ULL},
+		{"2.4703282292062327e-324",0x0000000000000000ULL}, // just below half of it
+		{"2.4703282292062328e-324",0x0000000000000001ULL}, // just above
+		{"2.2250738585072011e-308",0x000FFFFFFFFFFFFFULL}, // largest subnormal
+		{"2.2250738585072012e-308",0x0010000000000000ULL}, // smallest normal
+		{"1.00000000000000011102230246251565404236316680908203125",0x3FF0000000000000ULL}, // exactly halfway
+		{"1.00000000000000011102230246251565404236316680908203126",0x3FF0000000000001ULL},
+		{"123456789012345678901234567890",0x45F8EE90FF6C373EULL},
+		{"1e-300",0x01A56E1FC2F8F359ULL}, // past the exact powers of ten
+		{"123456789e-300",0x0353B645D2129C49ULL},
+		{"8.98846567431158e307",0x7FE0000000000000ULL},
+		{"1.7976931348623157e308",0x7FEFFFFFFFFFFFFFULL},
+	};
+	for (auto &d:doubles)
+		if (!rounds_to<double>(d.text,d.bits))
+			return false;
+	struct { const char *text; uint32_t bits; } floats[]={
+		{"0.1",0x3DCCCCCDu},
+		{"16777217",0x4B800000u}, // 2^24+1
+		{"16777219",0x4B800002u},
+		{"1.00000005960464477539062500",0x3F800000u}, // exactly halfway
+		{"1.000000059604644775390625001",0x3F800001u},
+		{"7.038531e-26",0x15AE43FDu}, // wrong if rounded to double first
+		{"1e23",0x65A96816u},
+		{"3.4028235e38",0x7F7FFFFFu},
+		{"1e-45",0x00000001u},
+		{"1.4e-45",0x00000001u},
+	};
+	for (auto &f:floats)
+		if (!rounds_to<float>(f.text,f.bits))
+			return false;
+	return true;
+}
+
+// number arrays read in bulk should give the same values and errors as reading the numbers one at a time.
+template<typename N>
+bool same_numbers(const std::vector<std::string> &numbers) {
+	std::string data="[";
+	std::vector<N> expected;
+	bool valid=true;
+	for (size_t i=0;i<numbers.size();i++) {
+		data+=(i?" , ":"")+numbers[i];
+		N n;
+		if (rpoco::parse_json(numbers[i],n))
+			expected.push_back(n);
+		else
+			valid=false;
+	}
+	data+="]";
+	std::vector<N> values;
+	if (rpoco::parse_json(data,values)!=valid)
+		return false;
+	return !valid || (values.size()==expected.size() && !memcmp(values.data(),expected.data(),values.size()*sizeof(N)));
+}
+
+bool bulk_checks() {
+	std::vector<std::string> numbers={"0","-0","1","-1","12345","0.5","-1.25e3","1E-7","3.141592653589793","2.7182818284590452353602874713527",
+		"123456789012345678","1234567890123456789","12345678901234567890","9007199254740993","1e22","1e23","4.9e-324","0.0000001234","1.0","100e-2"};
+	if (!same_numbers<double>(numbers) || !same_numbers<float>(numbers))
+		return false;
+	std::vector<std::string> integers={"0","-0","7","-2147483648","2147483647","1.0","100e-2","12e1"};
+	if (!same_numbers<int>(integers) || !same_numbers<int64_t>(integers) || !same_numbers<int64_t>({"-9223372036854775808","9223372036854775807"}))
+		return false;
+	if (!same_numbers<uint64_t>({"0","18446744073709551615","1e3"}))
+		return false;
+	// values out of range, fractions and bad syntax fail
+	if (!same_numbers<int>({"1","2147483648"}) || !same_numbers<int>({"1","1.5"}) || !same_numbers<uint64_t>({"-1"}))
+		return false;
+	std::vector<double> values;
+	const char *bad[]={"[1,]","[01]","[1.]","[-]","[1e]","[1 2]","[1,null]","[1"};
+	for (const char *b:bad)
+		if (rpoco::parse_json(std::string(b),values))
+			return false;
+	// a reused vector keeps its numbers when something other than an array comes
+	for (const char *other:{"null","5","{}"}) {
+		values.assign(2,1.5);
+		if (rpoco::parse_json_reuse(std::string(other),values) || values.size()!=2)
+			return false;
+	}
+	// numbers ending exactly at the end of the input and other vectors still work
+	std::vector<uint8_t> bytes;
+	values.clear();
+	if (!rpoco::parse_json(std::string("[1,/* c */2 /* d */,-3.5]"),values,true) || values.size()!=3 || values[2]!=-3.5)
+		return false;
+	values.clear();
+	return rpoco::parse_json(std::string("[1,2.5]"),values) && values.size()==2 && values[1]==2.5 &&
+		rpoco::parse_json(std::string("[1,255]"),bytes) && bytes.size()==2 && !rpoco::parse_json(std::string("[256]"),bytes);
+}
+
+// base64 fields should round trip all lengths and read Tiled style layer data.
+struct encoded_layer {
+	std::vector<uint32_t> data;
+	std::vector<uint8_t> bytes;
+	std::vector<float> floats;
+	RPOCO(_(data,rpoco::json::base64()),_(bytes,rpoco::json::base64()),_(floats,rpoco::json::base64()));
+};
+
+bool base64_checks() {
+	encoded_layer layer;
+	if (!rpoco::parse_json(std::string("{\"data\":\"AQAAAAIAAAADAAAA\",\"bytes\":\"TWFu\",\"floats\":[1.5,-2]}"),layer))
+		return false;
+	if (layer.data!=std::vector<uint32_t>({1,2,3}) || layer.bytes!=std::vector<uint8_t>({'M','a','n'}) || layer.floats!=std::vector<float>({1.5f,-2.0f}))
+		return false;
+	if (rpoco::to_json(layer)!="{\"data\":\"AQAAAAIAAAADAAAA\",\"bytes\":\"TWFu\",\"floats\":\"AADAPwAAAMA=\"}")
+		return false;
+	for (int len=0;len<100;len++) {
+		encoded_layer in,out;
+		for (int i=0;i<len;i++) {
+			in.data.push_back(i*2654435761u);
+			in.bytes.push_back((uint8_t)(i*37+len));
+			in.floats.push_back(i*0.25f-3);
+		}
+		if (!rpoco::parse_json(rpoco::to_json(in),out) || out.data!=in.data || out.bytes!=in.bytes || out.floats!=in.floats)
+			return false;
+	}
+	// characters outside of the alphabet, misplaced padding and partial elements are rejected
+	const char *bad[]={"{\"bytes\":\"TW-u\"}","{\"bytes\":\"T===\"}","{\"bytes\":\"TW=uTWFu\"}","{\"bytes\":\"TWF\"}","{\"data\":\"TWFu\"}",
+		"{\"bytes\":\"TWFuT!FuTWFuTWFuTWFuTWFu\"}"};
+	for (const char *b:bad)
+		if (rpoco::parse_json(std::string(b),layer))
+			return false;
+	return true;
+}
+
+// only the values at the requested paths should be parsed, into values or RPOCO targets.
+bool path_checks() {
+	std::string data="{\"user\":{\"name\":\"x\",\"id\":7,\"tags\":[1,2]},\"skip\":[{\"sku\":\"no\"}],\"items\":[{\"sku\":\"a\",\"n\":1},{\"n\":2},{\"sku\":\"c\"}],\"a/b\":{\"~\":true}}";
+	rpoco::json::value v;
+	if (!rpoco::json::parse_paths(data,{"/user/id","/items/*/sku","/a~1b/~0","/missing"},v))
+		return false;
+	if (rpoco::to_json(v)!="{\"/a~1b/~0\":true,\"/items/0/sku\":\"a\",\"/items/2/sku\":\"c\",\"/user/id\":7}")
+		return false;
+	int id=0;
+	std::vector<std::string> skus;
+	std::vector<line_record> items;
+	bool ok=rpoco::json::parse_paths(data,{"/user/id","/items/*/sku","/items"},[&](size_t path,const std::string &/*pointer*/,rpoco::visitor &pv) {
+		if (path==0)
+			rpoco::visit<int>(pv,id);
+		else if (path==1)
+			rpoco::visit<std::string>(pv,*skus.emplace(skus.end()));
+		else
+			rpoco::visit<std::vector<line_record>>(pv,items);
+	});
+	// the shorter /items path takes the whole array
+	if (!ok || id!=7 || skus.size() || items.size()!=3)
+		return false;
+	// the whole document and errors outside of the paths
+	rpoco::json::value whole;
+	if (!rpoco::json::parse_paths(data,{""},v) || !rpoco::parse_json(data,whole) || rpoco::to_json(v[""])!=rpoco::to_json(whole))
+		return false;
+	return !rpoco::json::parse_paths("{\"a\":1,\"b\":[}",{"/a"},v) && !rpoco::json::parse_paths("{\"a\":1,\"b\":x}",{"/a"},v);
+}
+
+// a number that counts its visits to see where the traversal stops.
+struct counted {
+	static size_t visits;
+	int n=0;
+};
+size_t counted::visits=0;
+namespace rpoco {
+	template<>
+	struct visit<counted> { visit(visitor &v,counted &c) {
+		counted::visits++;
+		v.visit(c.n);
+	}};
+}
+
+// streamed output should match to_json while only a buffer of it is held at a time.
+bool write_checks() {
+	std::vector<line_record> records(5000);
+	for (int i=0;i<(int)records.size();i++) {
+		records[i].id=i;
+		records[i].name="record \"" + std::to_string(i) + "\"";
+	}
+	std::string expected=rpoco::to_json(records);
+	std::string streamed;
+	size_t largest=0,calls=0;
+	bool ok=rpoco::write_json([&](const char *data,size_t size) {
+		streamed.append(data,size);
+		largest=std::max(largest,size);
+		calls++;
+		return true;
+	},records,1024);
+	if (!ok || streamed!=expected || calls<expected.size()/2048 || largest>1024+64)
+		return false;
+	std::ostringstream os;
+	if (!rpoco::write_json(os,records) || os.str()!=expected)
+		return false;
+	// a sink refusing output stops it
+	calls=0;
+	if (rpoco::write_json([&](const char*,size_t) { calls++; return false; },records,1024) || calls!=1)
+		return false;
+	// and the rest of the data isn't visited
+	std::vector<std::vector<counted>> numbers(100,std::vector<counted>(1000));
+	if (rpoco::write_json([](const char*,size_t) { return false; },numbers,1024) || counted::visits>1024)
+		return false;
+#ifndef _WIN32
+	FILE *f=tmpfile();
+	if (!f || !rpoco::write_json(fileno(f),records,4096))
+		return false;
+	std::string written(expected.size()+1,0);
+	rewind(f);
+	written.resize(fread(&written[0],1,written.size(),f));
+	fclose(f);
+	if (written!=expected)
+		return false;
+#endif
+	return true;
+}
+
 int main(int argc,char **argv) {
 	for (int i=1;i<argc;i++) {
 		if (std::string("-node-diff")==argv[i]) {
@@ -46,6 +1090,117 @@ int main(int argc,char **argv) {
 		}
 	}
 
+	if (!utf8_checks()) {
+		printf("Error, UTF-8 validation failed\n");
+		return -1;
+	}
+	printf("UTF-8 validation ok\n");
+	if (!push_checks() || !push_fill_checks()) {
+		printf("Error, push parsing failed\n");
+		return -1;
+	}
+	printf("push parsing ok\n");
+	if (!simd_checks()) {
+		printf("Error, vector kernels disagree with the scalar code\n");
+		return -1;
+	}
+	printf("vector kernels ok\n");
+	if (!integer_checks()) {
+		printf("Error, integer fields failed\n");
+		return -1;
+	}
+	printf("integer fields ok\n");
+	if (!key_checks()) {
+		printf("Error, key lookup failed\n");
+		return -1;
+	}
+	printf("key lookup ok\n");
+	if (!order_checks()) {
+		printf("Error, member order failed\n");
+		return -1;
+	}
+	printf("member order ok\n");
+	if (!string_ref_checks()) {
+		printf("Error, string_ref fields failed\n");
+		return -1;
+	}
+	printf("string_ref fields ok\n");
+	if (!select_checks()) {
+		printf("Error, polymorphic selection failed\n");
+		return -1;
+	}
+	printf("polymorphic selection ok\n");
+	if (!value_checks()) {
+		printf("Error, json values failed\n");
+		return -1;
+	}
+	printf("json values ok\n");
+	if (!lazy_checks()) {
+		printf("Error, lazy values failed\n");
+		return -1;
+	}
+	printf("lazy values ok\n");
+	if (!tape_checks()) {
+		printf("Error, tape documents failed\n");
+		return -1;
+	}
+	printf("tape documents ok\n");
+	if (!arena_checks()) {
+		printf("Error, arena parsing failed\n");
+		return -1;
+	}
+	printf("arena parsing ok\n");
+	if (!line_checks()) {
+		printf("Error, json lines failed\n");
+		return -1;
+	}
+	printf("json lines ok\n");
+	if (!array_checks()) {
+		printf("Error, parallel arrays failed\n");
+		return -1;
+	}
+	printf("parallel arrays ok\n");
+	if (!skip_checks()) {
+		printf("Error, skipping unknown fields failed\n");
+		return -1;
+	}
+	printf("unknown fields skipped ok\n");
+	if (!reuse_checks()) {
+		printf("Error, reused parsing failed\n");
+		return -1;
+	}
+	printf("reused parsing ok\n");
+	if (!hint_checks()) {
+		printf("Error, array size hints failed\n");
+		return -1;
+	}
+	printf("array size hints ok\n");
+	if (!rounding_checks()) {
+		printf("Error, number rounding failed\n");
+		return -1;
+	}
+	printf("number rounding ok\n");
+	if (!bulk_checks()) {
+		printf("Error, bulk number arrays failed\n");
+		return -1;
+	}
+	printf("bulk number arrays ok\n");
+	if (!base64_checks()) {
+		printf("Error, base64 fields failed\n");
+		return -1;
+	}
+	printf("base64 fields ok\n");
+	if (!path_checks()) {
+		printf("Error, path selection failed\n");
+		return -1;
+	}
+	printf("path selection ok\n");
+	if (!write_checks()) {
+		printf("Error, streamed writing failed\n");
+		return -1;
+	}
+	printf("streamed writing ok\n");
+
 	path p="json";
 	p/="json_parser";
 	printf("%s\n",p.string().c_str());
@@ -59,22 +1214,28 @@ int main(int argc,char **argv) {
 
 		for (int i = 0; i< (doExt ? 2 : 1); i++) {
 			json_value *jv = 0;
-			bool pr = parse(std::ifstream(it->path().string().c_str()),jv,i==1);	
+			bool pr = rpoco::parse_json_file(it->path().string(),jv,i==1);
 			bool curWanted = (i == 1 ? extWanted : wanted);
+#ifndef _WIN32
+			if (!push_matches(it->path().string(),i==1,pr,jv)) {
+				printf("Error, %s gave a different result with the push parser%s\n",it->path().string().c_str(),i==1?" with extensions":"");
+				return -1;
+			}
+#endif
 			if (curWanted == pr) {
 				printf("%s was %s as expected%s\n",it->path().string().c_str(),pr ? "parsed" : "not parsed",i==1?" with extensions":"");
 				if (pr && node_diff) {
 					std::string outname = it->path().string() + ".out";
 					{
 						std::ofstream os(outname);
-						os << to_json(jv);
+						os << rpoco::to_json(jv);
 					}
 					std::string cmd = "node json_diff.js " + it->path().string() + " " + outname;
 					std::system(cmd.c_str());
 				}
 			} else {
 				printf("Error, %s was unexpectedly %s\n",it->path().string().c_str(),pr ? "parsed" : "not parsed");
-				printf("parsed ok?:%s wanted:%s to:%s\n",pr ? "true" : "false",curWanted ? "t" : "f",to_json(jv).c_str());
+				printf("parsed ok?:%s wanted:%s to:%s\n",pr ? "true" : "false",curWanted ? "t" : "f",rpoco::to_json(jv).c_str());
 				return -1;
 			}
 			if (jv)